@@ -0,0 +1,56 @@
+#include "pch.h"
+#include "AssetLoader.h"
+
+#include <filesystem>
+
+namespace dae
+{
+	AssetLoader::AssetLoader()
+		// Keep one core free for the main thread, it keeps rendering while assets stream in
+		: m_ThreadPool{ std::max(std::thread::hardware_concurrency(), 2u) - 1 }
+	{
+	}
+
+	std::future<Texture*> AssetLoader::LoadTextureAsync(ID3D11Device* pDevice, const std::string& path)
+	{
+		return m_ThreadPool.Enqueue([pDevice, path]
+			{
+				return Texture::LoadFromFile(pDevice, path);
+			});
+	}
+
+	std::future<StreamingMesh*> AssetLoader::LoadStreamingMeshAsync(const std::string& objPath, size_t memoryBudget)
+	{
+		return m_ThreadPool.Enqueue([objPath, memoryBudget]() -> StreamingMesh*
+			{
+				const std::string cookedPath{ StreamingMesh::GetCookedPath(objPath) };
+
+				std::error_code error{};
+				const bool isCooked{ std::filesystem::exists(cookedPath, error)
+					&& std::filesystem::last_write_time(cookedPath, error) >= std::filesystem::last_write_time(objPath, error) };
+
+				if (!isCooked && !StreamingMesh::Cook(objPath, cookedPath))
+					return nullptr;
+
+				StreamingMesh* pMesh{ new StreamingMesh{ cookedPath, memoryBudget } };
+
+				// A file newer than the OBJ can still be from an older format or cut short, it is cooked again once
+				if (!pMesh->IsValid() && isCooked)
+				{
+					delete pMesh;
+					pMesh = nullptr;
+
+					std::cout << "AssetLoader: " << cookedPath << " is outdated or corrupt, cooking it again\n";
+					if (StreamingMesh::Cook(objPath, cookedPath)) pMesh = new StreamingMesh{ cookedPath, memoryBudget };
+				}
+
+				if (!pMesh || !pMesh->IsValid())
+				{
+					delete pMesh;
+					return nullptr;
+				}
+
+				return pMesh;
+			});
+	}
+}
@@ -0,0 +1,137 @@
+#pragma once
+#include "ThreadPool.h"
+#include "Effect.h"
+#include "GltfFile.h"
+#include "Mesh.h"
+#include "StreamingMesh.h"
+#include "Texture.h"
+#include "Utils.h"
+
+namespace dae
+{
+	// Loads meshes and textures on a pool of worker threads.
+	// Every load returns a future, the caller decides when to pick up the result.
+	class AssetLoader final
+	{
+	public:
+		AssetLoader();
+		~AssetLoader() = default;
+
+		AssetLoader(const AssetLoader&) = delete;
+		AssetLoader(AssetLoader&&) noexcept = delete;
+		AssetLoader& operator=(const AssetLoader&) = delete;
+		AssetLoader& operator=(AssetLoader&&) noexcept = delete;
+
+		// Parses the OBJ, compiles the effect and creates the GPU buffers.
+		// ID3D11Device is free threaded, so all of this can happen off the main thread.
+		template <typename EffectType>
+		std::future<Mesh*> LoadMeshAsync(ID3D11Device* pDevice, const std::string& objPath, const std::wstring& effectPath)
+		{
+			return m_ThreadPool.Enqueue([pDevice, objPath, effectPath]() -> Mesh*
+				{
+					std::vector<Vertex_In> vertices;
+					std::vector<uint32_t> indices;
+					if (!Utils::ParseOBJ(objPath, vertices, indices))
+					{
+						std::cout << "Failed to load mesh from file: " << objPath << '\n';
+						return nullptr;
+					}
+
+					Mesh* pMesh{ new Mesh{ pDevice, new EffectType{ pDevice, effectPath }, vertices, indices } };
+					pMesh->SetIndices(indices);
+					pMesh->SetVertices(vertices);
+					pMesh->BuildLods();
+					pMesh->Compress();
+
+					return pMesh;
+				});
+		}
+
+		// Creates a mesh for every primitive of a .glb, with the base color and normal textures of its material
+		template <typename EffectType>
+		std::future<LoadedModel> LoadModelAsync(ID3D11Device* pDevice, const std::string& glbPath, const std::wstring& effectPath)
+		{
+			return m_ThreadPool.Enqueue([pDevice, glbPath, effectPath]() -> LoadedModel
+				{
+					LoadedModel model{};
+
+					GltfFile file{};
+					if (!file.Open(glbPath))
+					{
+						std::cout << "Failed to load model from file: " << glbPath << '\n';
+						return model;
+					}
+
+					// Textures can be shared by several materials, only load each of them once
+					std::vector<int> textureIndices{};
+					const auto getTexture{ [&](int texture) -> const Texture*
+						{
+							if (texture < 0) return nullptr;
+
+							const auto it{ std::ranges::find(textureIndices, texture) };
+							if (it != textureIndices.end()) return model.textures[it - textureIndices.begin()];
+
+							const std::span<const uint8_t> image{ file.GetTextureImage(texture) };
+							const Texture* pTexture
+							{
+								image.empty() ?
+								Texture::LoadFromFile(pDevice, file.GetTextureUri(texture)) :
+								Texture::LoadFromMemory(pDevice, image, glbPath + " texture " + std::to_string(texture))
+							};
+
+							textureIndices.emplace_back(texture);
+							model.textures.emplace_back(pTexture);
+							return pTexture;
+						} };
+
+					// The effect file is compiled once, every primitive gets a clone with its own textures and matrices
+					ID3DX11Effect* pEffect{ Effect::LoadEffect(pDevice, effectPath) };
+					if (!pEffect) return model;
+
+					std::vector<Vertex_In> vertices;
+					std::vector<uint32_t> indices;
+					for (const GltfFile::Primitive& primitive : file.GetPrimitives())
+					{
+						if (!file.ReadPrimitive(primitive, vertices, indices) || indices.empty()) continue;
+
+						ID3DX11Effect* pClone{ Effect::CloneEffect(pEffect) };
+						if (!pClone) continue;
+
+						Mesh* pMesh{ new Mesh{ pDevice, new EffectType{ pClone }, vertices, indices } };
+						pMesh->SetIndices(indices);
+						pMesh->SetVertices(vertices);
+						pMesh->BuildLods();
+						pMesh->Compress();
+
+						if (primitive.material >= 0 && primitive.material < static_cast<int>(file.GetMaterials().size()))
+						{
+							const GltfFile::Material& material{ file.GetMaterials()[primitive.material] };
+							if (const Texture* pDiffuse{ getTexture(material.baseColorTexture) }) pMesh->SetDiffuse(pDiffuse);
+							if (const Texture* pNormal{ getTexture(material.normalTexture) }) pMesh->SetNormal(pNormal);
+						}
+
+						model.meshes.emplace_back(pMesh);
+					}
+					pEffect->Release();
+
+					// Textures that failed to load are not handed out
+					std::erase(model.textures, nullptr);
+					return model;
+				});
+		}
+
+		std::future<Texture*> LoadTextureAsync(ID3D11Device* pDevice, const std::string& path);
+
+		// Cooks the OBJ into the clustered format when there is no up to date cooked file yet
+		std::future<StreamingMesh*> LoadStreamingMeshAsync(const std::string& objPath, size_t memoryBudget);
+
+		template <typename Future>
+		static bool IsReady(const Future& future)
+		{
+			return future.wait_for(std::chrono::seconds{ 0 }) == std::future_status::ready;
+		}
+
+	private:
+		ThreadPool m_ThreadPool;
+	};
+}
@@ -0,0 +1,165 @@
+#include "pch.h"
+#include "Bvh.h"
+
+#include <numeric>
+
+namespace dae
+{
+	void Bvh::Build(const std::vector<Box>& boxes)
+	{
+		m_Nodes.clear();
+		m_DirtyLeaves.clear();
+		m_ItemLeaves.assign(boxes.size(), -1);
+		if (boxes.empty()) return;
+
+		// A binary tree with one item per leaf has 2n - 1 nodes
+		m_Nodes.reserve(boxes.size() * 2 - 1);
+
+		std::vector<uint32_t> items(boxes.size());
+		std::iota(items.begin(), items.end(), 0);
+		BuildNode(items, 0, items.size(), boxes, -1);
+
+		m_BuiltRootArea = SurfaceArea(m_Nodes.front().box);
+	}
+
+	int Bvh::BuildNode(std::vector<uint32_t>& items, size_t first, size_t last, const std::vector<Box>& boxes, int parent)
+	{
+		const int nodeIndex{ static_cast<int>(m_Nodes.size()) };
+		m_Nodes.emplace_back();
+		m_Nodes[nodeIndex].parent = parent;
+
+		if (last - first == 1)
+		{
+			Node& leaf{ m_Nodes[nodeIndex] };
+			leaf.box = boxes[items[first]];
+			leaf.item = items[first];
+			m_ItemLeaves[leaf.item] = nodeIndex;
+			return nodeIndex;
+		}
+
+		// Split at the median of the box centers along the longest axis of their bounds
+		Box centerBounds{ boxes[items[first]].min + boxes[items[first]].max, boxes[items[first]].min + boxes[items[first]].max };
+		for (size_t i{ first + 1 }; i < last; ++i)
+		{
+			const Vector3 center{ boxes[items[i]].min + boxes[items[i]].max };
+			centerBounds = Union(centerBounds, { center, center });
+		}
+
+		const Vector3 size{ centerBounds.max - centerBounds.min };
+		const int axis{ size.x >= size.y && size.x >= size.z ? 0 : (size.y >= size.z ? 1 : 2) };
+
+		const size_t middle{ first + (last - first) / 2 };
+		std::nth_element(items.begin() + first, items.begin() + middle, items.begin() + last, [&boxes, axis](uint32_t a, uint32_t b)
+			{
+				return boxes[a].min[axis] + boxes[a].max[axis] < boxes[b].min[axis] + boxes[b].max[axis];
+			});
+
+		// Children are built after their parent, so every child has a higher index than its parent
+		const int left{ BuildNode(items, first, middle, boxes, nodeIndex) };
+		const int right{ BuildNode(items, middle, last, boxes, nodeIndex) };
+
+		Node& node{ m_Nodes[nodeIndex] };
+		node.left = left;
+		node.right = right;
+		node.box = Union(m_Nodes[left].box, m_Nodes[right].box);
+		return nodeIndex;
+	}
+
+	void Bvh::SetBox(uint32_t item, const Box& box)
+	{
+		const int leaf{ m_ItemLeaves[item] };
+		m_Nodes[leaf].box = box;
+		m_DirtyLeaves.emplace_back(leaf);
+	}
+
+	void Bvh::Refit()
+	{
+		if (m_DirtyLeaves.empty()) return;
+
+		for (const int leaf : m_DirtyLeaves)
+		{
+			// Walk up until a parent already encloses its children, the rest of the path is then up to date too
+			for (int node{ m_Nodes[leaf].parent }; node >= 0; node = m_Nodes[node].parent)
+			{
+				const Box box{ Union(m_Nodes[m_Nodes[node].left].box, m_Nodes[m_Nodes[node].right].box) };
+				const Box& current{ m_Nodes[node].box };
+				if (box.min.x == current.min.x && box.min.y == current.min.y && box.min.z == current.min.z &&
+					box.max.x == current.max.x && box.max.y == current.max.y && box.max.z == current.max.z) break;
+
+				m_Nodes[node].box = box;
+			}
+		}
+		m_DirtyLeaves.clear();
+
+		// Items that moved far apart leave large, mostly empty boxes behind, a rebuild restores a tight tree
+		if (SurfaceArea(m_Nodes.front().box) <= m_BuiltRootArea * m_MaxAreaGrowth) return;
+
+		std::vector<Box> boxes(m_ItemLeaves.size());
+		for (uint32_t item{ 0 }; item < boxes.size(); ++item)
+		{
+			boxes[item] = GetBox(item);
+		}
+		Build(boxes);
+	}
+
+	Bvh::Box Bvh::TransformBox(const Vector3& boundsMin, const Vector3& boundsMax, const Matrix& worldMatrix)
+	{
+		const Vector3 center{ worldMatrix.TransformPoint((boundsMin + boundsMax) * .5f) };
+		const Vector3 extents{ (boundsMax - boundsMin) * .5f };
+
+		// Every world axis gathers the absolute contribution of each local axis
+		Vector3 worldExtents{};
+		for (int axis{ 0 }; axis < 3; ++axis)
+		{
+			worldExtents[axis] = std::abs(worldMatrix[0][axis]) * extents.x + std::abs(worldMatrix[1][axis]) * extents.y + std::abs(worldMatrix[2][axis]) * extents.z;
+		}
+
+		return { center - worldExtents, center + worldExtents };
+	}
+
+	float Bvh::IntersectRay(const Box& box, const Vector3& origin, const Vector3& inverseDirection, float maxDistance)
+	{
+		// Slab test, the entry distance is the largest near plane and the exit distance the smallest far plane
+		float entry{ 0.f };
+		float exit{ maxDistance };
+		for (int axis{ 0 }; axis < 3; ++axis)
+		{
+			float nearDistance{ (box.min[axis] - origin[axis]) * inverseDirection[axis] };
+			float farDistance{ (box.max[axis] - origin[axis]) * inverseDirection[axis] };
+			if (nearDistance > farDistance) std::swap(nearDistance, farDistance);
+
+			// A ray parallel to the slab gives NaN when it starts on the boundary, std::max and std::min then keep the previous value
+			entry = std::max(entry, nearDistance);
+			exit = std::min(exit, farDistance);
+		}
+
+		return entry <= exit ? entry : FLT_MAX;
+	}
+
+	Bvh::Box Bvh::Union(const Box& a, const Box& b)
+	{
+		return
+		{
+			{ std::min(a.min.x, b.min.x), std::min(a.min.y, b.min.y), std::min(a.min.z, b.min.z) },
+			{ std::max(a.max.x, b.max.x), std::max(a.max.y, b.max.y), std::max(a.max.z, b.max.z) }
+		};
+	}
+
+	float Bvh::SurfaceArea(const Box& box)
+	{
+		const Vector3 size{ box.max - box.min };
+		return 2.f * (size.x * size.y + size.y * size.z + size.z * size.x);
+	}
+
+	float Bvh::SqrDistance(const Box& box, const Vector3& point)
+	{
+		// Distance to the closest point of the box, zero when the point is inside
+		const Vector3 closest
+		{
+			std::clamp(point.x, box.min.x, box.max.x),
+			std::clamp(point.y, box.min.y, box.max.y),
+			std::clamp(point.z, box.min.z, box.max.z)
+		};
+		return (closest - point).SqrMagnitude();
+	}
+}
@@ -0,0 +1,176 @@
+#pragma once
+#include "Frustum.h"
+
+namespace dae
+{
+	// Bounding volume hierarchy over a set of world space boxes, one leaf per item.
+	// Moving items only refit the boxes on the path to the root, the tree is rebuilt once refitting has loosened it too much.
+	class Bvh final
+	{
+	public:
+		struct Box
+		{
+			Vector3 min{};
+			Vector3 max{};
+		};
+
+		Bvh() = default;
+		~Bvh() = default;
+
+		Bvh(const Bvh&) = delete;
+		Bvh(Bvh&&) noexcept = delete;
+		Bvh& operator=(const Bvh&) = delete;
+		Bvh& operator=(Bvh&&) noexcept = delete;
+
+		// Builds the tree top down, the index of a box is its item
+		void Build(const std::vector<Box>& boxes);
+
+		// Updates the box of an item, the tree is only refit in Refit
+		void SetBox(uint32_t item, const Box& box);
+		void Refit();
+
+		// Calls callback(item, isInside) for every item in a node that intersects the frustum, leaves themselves are not tested.
+		// isInside is true when an ancestor lies completely inside the frustum, the item is then visible without further tests.
+		// Nearer children are visited first, so the items come roughly front to back as seen from the eye.
+		template <typename Callback>
+		void QueryFrustum(const Frustum& frustum, const Vector3& eye, Callback&& callback) const;
+
+		// Calls callback(item, maxDistance) for every item whose box the ray hits within maxDistance, nearest boxes first.
+		// The callback can shorten maxDistance once it found an exact hit, farther boxes are then skipped.
+		template <typename Callback>
+		void Raycast(const Vector3& origin, const Vector3& direction, float maxDistance, Callback&& callback) const;
+
+		// Getters
+		size_t GetItemCount() const { return m_ItemLeaves.size(); }
+		size_t GetNodeCount() const { return m_Nodes.size(); }
+		const Box& GetBox(uint32_t item) const { return m_Nodes[m_ItemLeaves[item]].box; }
+
+		// Box around an object space box transformed by a world matrix
+		static Box TransformBox(const Vector3& boundsMin, const Vector3& boundsMax, const Matrix& worldMatrix);
+		// Entry distance of the ray into the box, FLT_MAX when it misses
+		static float IntersectRay(const Box& box, const Vector3& origin, const Vector3& inverseDirection, float maxDistance);
+
+	private:
+		// Children of an inner node, item of a leaf
+		struct Node
+		{
+			Box box{};
+			int parent{ -1 };
+			int left{ -1 };
+			int right{ -1 };
+			uint32_t item{};
+
+			bool IsLeaf() const { return left < 0; }
+		};
+
+		std::vector<Node> m_Nodes{};
+		std::vector<int> m_ItemLeaves{};
+		std::vector<int> m_DirtyLeaves{};
+
+		// Surface area of the root when the tree was built, refitting it past m_MaxAreaGrowth times that triggers a rebuild
+		float m_BuiltRootArea{};
+		static constexpr float m_MaxAreaGrowth{ 2.f };
+
+		// Deep enough for any tree built from a median split
+		static constexpr int m_MaxStackSize{ 64 };
+
+		int BuildNode(std::vector<uint32_t>& items, size_t first, size_t last, const std::vector<Box>& boxes, int parent);
+
+		static Box Union(const Box& a, const Box& b);
+		static float SurfaceArea(const Box& box);
+		static float SqrDistance(const Box& box, const Vector3& point);
+	};
+
+	template <typename Callback>
+	void Bvh::QueryFrustum(const Frustum& frustum, const Vector3& eye, Callback&& callback) const
+	{
+		if (m_Nodes.empty()) return;
+
+		// Nodes whose box lies completely inside the frustum hand out all of their leaves without further tests
+		struct Entry
+		{
+			int node;
+			bool isInside;
+		};
+		Entry stack[m_MaxStackSize];
+		int stackSize{ 0 };
+		stack[stackSize++] = { 0, false };
+
+		while (stackSize > 0)
+		{
+			const Entry entry{ stack[--stackSize] };
+			const Node& node{ m_Nodes[entry.node] };
+
+			// Leaf boxes are left to the caller, who can test many of them at once
+			if (node.IsLeaf())
+			{
+				callback(node.item, entry.isInside);
+				continue;
+			}
+
+			bool isInside{ entry.isInside };
+			if (!isInside)
+			{
+				const Vector3 center{ (node.box.min + node.box.max) * .5f };
+				const Vector3 extents{ (node.box.max - node.box.min) * .5f };
+
+				const Frustum::Containment containment{ frustum.Classify(center, extents) };
+				if (containment == Frustum::Containment::Outside) continue;
+				isInside = containment == Frustum::Containment::Inside;
+			}
+
+			// Push the farther child first, so the nearer one is popped next
+			const bool isLeftNearer{ SqrDistance(m_Nodes[node.left].box, eye) <= SqrDistance(m_Nodes[node.right].box, eye) };
+			stack[stackSize++] = { isLeftNearer ? node.right : node.left, isInside };
+			stack[stackSize++] = { isLeftNearer ? node.left : node.right, isInside };
+		}
+	}
+
+	template <typename Callback>
+	void Bvh::Raycast(const Vector3& origin, const Vector3& direction, float maxDistance, Callback&& callback) const
+	{
+		if (m_Nodes.empty()) return;
+
+		const Vector3 inverseDirection{ 1.f / direction.x, 1.f / direction.y, 1.f / direction.z };
+
+		struct Entry
+		{
+			int node;
+			float distance;
+		};
+		Entry stack[m_MaxStackSize];
+		int stackSize{ 0 };
+
+		const float rootDistance{ IntersectRay(m_Nodes.front().box, origin, inverseDirection, maxDistance) };
+		if (rootDistance == FLT_MAX) return;
+		stack[stackSize++] = { 0, rootDistance };
+
+		while (stackSize > 0)
+		{
+			const Entry entry{ stack[--stackSize] };
+
+			// The callback may have found a hit closer than this box since it was pushed
+			if (entry.distance > maxDistance) continue;
+
+			const Node& node{ m_Nodes[entry.node] };
+			if (node.IsLeaf())
+			{
+				callback(node.item, maxDistance);
+				continue;
+			}
+
+			float leftDistance{ IntersectRay(m_Nodes[node.left].box, origin, inverseDirection, maxDistance) };
+			float rightDistance{ IntersectRay(m_Nodes[node.right].box, origin, inverseDirection, maxDistance) };
+			int nearChild{ node.left };
+			int farChild{ node.right };
+			if (rightDistance < leftDistance)
+			{
+				std::swap(leftDistance, rightDistance);
+				std::swap(nearChild, farChild);
+			}
+
+			if (rightDistance != FLT_MAX) stack[stackSize++] = { farChild, rightDistance };
+			if (leftDistance != FLT_MAX) stack[stackSize++] = { nearChild, leftDistance };
+		}
+	}
+}
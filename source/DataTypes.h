@@ -4,6 +4,9 @@
 
 namespace dae
 {
+	class Mesh;
+	class Texture;
+
 	struct Vertex_In
 	{
 		Vector3 pos{};
@@ -20,7 +23,23 @@ namespace dae
 		Vector3 tan{};
 		Vector2 uv{};
 		ColorRGB col{ colors::White };
-		Vector3 view{};
+		// World space position, the view vector is taken per pixel so moving the camera leaves it valid
+		Vector3 worldPos{};
+	};
+
+	struct Material
+	{
+		const Texture* pDiffuse{ nullptr };
+		const Texture* pNormal{ nullptr };
+		const Texture* pGloss{ nullptr };
+		const Texture* pSpecular{ nullptr };
+	};
+
+	// Meshes of a model file with the textures they use, owned by whoever picks them up
+	struct LoadedModel
+	{
+		std::vector<Mesh*> meshes{};
+		std::vector<const Texture*> textures{};
 	};
 
 	struct LightingData
@@ -43,4 +62,14 @@ namespace dae
 		TriangleList,
 		TriangleStrip
 	};
+
+	// Block of pixels that share one shaded color in the software rasterizer, the first bit doubles the width and the second the height.
+	// The coarser of two rates on each axis is their bitwise or.
+	enum class ShadingRate : uint8_t
+	{
+		Rate1x1 = 0,
+		Rate2x1 = 1,
+		Rate1x2 = 2,
+		Rate2x2 = 3
+	};
 };
@@ -0,0 +1,97 @@
+#pragma once
+#include <immintrin.h>
+
+namespace dae
+{
+	// Formats of the software depth buffer. The depth of a pixel is encoded from the interpolated inverse depth and inverse w,
+	// the rasterizer is compiled once per format so the encoding and compare function are known at compile time.
+	enum class DepthFormat
+	{
+		// Post projective z, nearer is smaller
+		Float,
+		// 1/w, nearer is larger. Equivalent to reversed z with the far plane at infinity, float spends its precision evenly on it
+		ReversedFloat,
+		// Post projective z quantized to 24 or 16 bits, nearer is smaller
+		Unorm24,
+		Unorm16
+	};
+
+	template <DepthFormat Format>
+	struct DepthTraits;
+
+	template <>
+	struct DepthTraits<DepthFormat::Float>
+	{
+		using Type = float;
+		static constexpr Type m_ClearValue{ FLT_MAX };
+
+		static Type Encode(float inverseDepth, float) { return 1.f / inverseDepth; }
+		static bool IsNearer(Type depth, Type current) { return depth < current; }
+
+		// Eight depths at once, kept as floats in between loading and storing
+		static __m256 Encode8(__m256 inverseDepth, __m256) { return _mm256_div_ps(_mm256_set1_ps(1.f), inverseDepth); }
+		static __m256 IsNearer8(__m256 depth, __m256 current) { return _mm256_cmp_ps(depth, current, _CMP_LT_OQ); }
+		static __m256 Load8(const Type* pDepths) { return _mm256_loadu_ps(pDepths); }
+		static void Store8(Type* pDepths, __m256 depths) { _mm256_storeu_ps(pDepths, depths); }
+	};
+
+	template <>
+	struct DepthTraits<DepthFormat::ReversedFloat>
+	{
+		using Type = float;
+		static constexpr Type m_ClearValue{ 0.f };
+
+		// Needs no division, inverse w is interpolated linearly already
+		static Type Encode(float, float inverseW) { return inverseW; }
+		static bool IsNearer(Type depth, Type current) { return depth > current; }
+
+		static __m256 Encode8(__m256, __m256 inverseW) { return inverseW; }
+		static __m256 IsNearer8(__m256 depth, __m256 current) { return _mm256_cmp_ps(depth, current, _CMP_GT_OQ); }
+		static __m256 Load8(const Type* pDepths) { return _mm256_loadu_ps(pDepths); }
+		static void Store8(Type* pDepths, __m256 depths) { _mm256_storeu_ps(pDepths, depths); }
+	};
+
+	template <>
+	struct DepthTraits<DepthFormat::Unorm24>
+	{
+		// The top byte stays zero
+		using Type = uint32_t;
+		static constexpr Type m_ClearValue{ 0xFFFFFF };
+
+		static Type Encode(float inverseDepth, float) { return static_cast<Type>(std::min(1.f / inverseDepth, 1.f) * m_ClearValue + .5f); }
+		static bool IsNearer(Type depth, Type current) { return depth < current; }
+
+		// 24 bit integers convert to float exactly, so they are compared as floats
+		static __m256 Encode8(__m256 inverseDepth, __m256)
+		{
+			const __m256 depth{ _mm256_min_ps(_mm256_div_ps(_mm256_set1_ps(1.f), inverseDepth), _mm256_set1_ps(1.f)) };
+			return _mm256_round_ps(_mm256_mul_ps(depth, _mm256_set1_ps(static_cast<float>(m_ClearValue))), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+		}
+		static __m256 IsNearer8(__m256 depth, __m256 current) { return _mm256_cmp_ps(depth, current, _CMP_LT_OQ); }
+		static __m256 Load8(const Type* pDepths) { return _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(pDepths))); }
+		static void Store8(Type* pDepths, __m256 depths) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(pDepths), _mm256_cvtps_epi32(depths)); }
+	};
+
+	template <>
+	struct DepthTraits<DepthFormat::Unorm16>
+	{
+		using Type = uint16_t;
+		static constexpr Type m_ClearValue{ 0xFFFF };
+
+		static Type Encode(float inverseDepth, float) { return static_cast<Type>(std::min(1.f / inverseDepth, 1.f) * m_ClearValue + .5f); }
+		static bool IsNearer(Type depth, Type current) { return depth < current; }
+
+		static __m256 Encode8(__m256 inverseDepth, __m256)
+		{
+			const __m256 depth{ _mm256_min_ps(_mm256_div_ps(_mm256_set1_ps(1.f), inverseDepth), _mm256_set1_ps(1.f)) };
+			return _mm256_round_ps(_mm256_mul_ps(depth, _mm256_set1_ps(static_cast<float>(m_ClearValue))), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+		}
+		static __m256 IsNearer8(__m256 depth, __m256 current) { return _mm256_cmp_ps(depth, current, _CMP_LT_OQ); }
+		static __m256 Load8(const Type* pDepths) { return _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pDepths)))); }
+		static void Store8(Type* pDepths, __m256 depths)
+		{
+			const __m256i values{ _mm256_cvtps_epi32(depths) };
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pDepths), _mm_packus_epi32(_mm256_castsi256_si128(values), _mm256_extracti128_si256(values, 1)));
+		}
+	};
+}
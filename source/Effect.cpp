@@ -10,6 +10,13 @@ namespace dae
 		CaptureTechniques();
 	}
 
+	Effect::Effect(ID3DX11Effect* pEffect)
+		: m_pEffect{ pEffect }
+	{
+		InitVariables();
+		CaptureTechniques();
+	}
+
 	Effect::~Effect()
 	{
 		m_pEffect->Release();
@@ -20,7 +27,7 @@ namespace dae
 	{
 		HRESULT result;
 		ID3D10Blob* pErrorBlob{ nullptr };
-		ID3DX11Effect* pEffect;
+		ID3DX11Effect* pEffect{ nullptr };
 
 		DWORD shaderFlags{ 0 };
 #if defined( DEBUG ) || defined( _DEBUG )
@@ -68,6 +75,18 @@ namespace dae
 		return pEffect;
 	}
 
+	ID3DX11Effect* Effect::CloneEffect(ID3DX11Effect* pEffect)
+	{
+		ID3DX11Effect* pClone{ nullptr };
+		if (FAILED(pEffect->CloneEffect(0, &pClone)))
+		{
+			std::wcout << L"EffectLoader: Failed to CloneEffect!\n";
+			return nullptr;
+		}
+
+		return pClone;
+	}
+
 	void Effect::SetTechnique(ID3DX11EffectTechnique* pTechnique)
 	{
 		if (!pTechnique->IsValid())
@@ -8,6 +8,8 @@ namespace dae
 	{
 	public:
 		explicit Effect(ID3D11Device* pDevice, const std::wstring& assetFile);
+		// Takes ownership of an effect that was created already, such as a clone of another one
+		explicit Effect(ID3DX11Effect* pEffect);
 
 		Effect(const Effect& other) = delete;
 		Effect(Effect&& other) noexcept = delete;
@@ -17,6 +19,8 @@ namespace dae
 		virtual ~Effect();
 
 		static ID3DX11Effect* LoadEffect(ID3D11Device* pDevice, const std::wstring& assetFile);
+		// The clone shares the compiled shaders of the effect but has variables of its own
+		static ID3DX11Effect* CloneEffect(ID3DX11Effect* pEffect);
 
 		// Getter functions
 		const std::vector<ID3DX11EffectTechnique*>& GetTechniques() const { return m_Techniques; }
@@ -10,6 +10,12 @@ namespace dae
 		InitVariables();
 	}
 
+	EffectFire::EffectFire(ID3DX11Effect* pEffect)
+		: Effect{ pEffect }
+	{
+		InitVariables();
+	}
+
 	void EffectFire::SetMatrices(const Matrix& world, const Matrix& viewProj, const Matrix& invView) const
 	{
 		Effect::GetMatWorldViewProjVariable()->SetMatrix(reinterpret_cast<const float*>(&viewProj));
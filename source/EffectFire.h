@@ -7,6 +7,7 @@ namespace dae
 	{
 	public:
 		explicit EffectFire(ID3D11Device* pDevice, const std::wstring& assetFile);
+		explicit EffectFire(ID3DX11Effect* pEffect);
 
 		void SetMatrices(const Matrix& world, const Matrix& viewProj, const Matrix& invView) const override;
 
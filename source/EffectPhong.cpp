@@ -10,6 +10,12 @@ namespace dae
 		InitVariables();
 	}
 
+	EffectPhong::EffectPhong(ID3DX11Effect* pEffect)
+		: Effect{ pEffect }
+	{
+		InitVariables();
+	}
+
 	void EffectPhong::InitVariables()
 	{
 		m_pMatWorldVariable = GetEffect()->GetVariableByName("gWorld")->AsMatrix();
@@ -9,6 +9,7 @@ namespace dae
 	{
 	public:
 		explicit EffectPhong(ID3D11Device* pDevice, const std::wstring& assetFile);
+		explicit EffectPhong(ID3DX11Effect* pEffect);
 
 		// Getters
 		ID3DX11EffectMatrixVariable* GetMatWorldVariable() const { return m_pMatWorldVariable; }
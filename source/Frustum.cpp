@@ -0,0 +1,119 @@
+#include "pch.h"
+#include "Frustum.h"
+
+#include <immintrin.h>
+
+namespace dae
+{
+	Frustum Frustum::FromViewProjection(const Matrix& viewProj)
+	{
+		// Row vectors: clip = p * viewProj, so every clip coordinate is the dot product of p with a column
+		const auto column{ [&viewProj](int index)
+			{
+				return Vector4{ viewProj[0][index], viewProj[1][index], viewProj[2][index], viewProj[3][index] };
+			} };
+
+		const Vector4 x{ column(0) };
+		const Vector4 y{ column(1) };
+		const Vector4 z{ column(2) };
+		const Vector4 w{ column(3) };
+
+		// -w <= x <= w, -w <= y <= w, 0 <= z <= w
+		Frustum frustum{ { w + x, w - x, w + y, w - y, z, w - z } };
+		for (Vector4& plane : frustum.planes)
+		{
+			const float length{ plane.GetXYZ().Magnitude() };
+			if (length > 0.f) plane = plane * (1.f / length);
+		}
+
+		return frustum;
+	}
+
+	Frustum::Containment Frustum::Classify(const Vector3& center, const Vector3& extents) const
+	{
+		Containment containment{ Containment::Inside };
+		for (const Vector4& plane : planes)
+		{
+			const float distance{ plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w };
+			const float radius{ std::abs(plane.x) * extents.x + std::abs(plane.y) * extents.y + std::abs(plane.z) * extents.z };
+			if (distance + radius < 0.f) return Containment::Outside;
+			if (distance - radius < 0.f) containment = Containment::Intersecting;
+		}
+
+		return containment;
+	}
+
+	void FrustumCuller::Clear()
+	{
+		m_CenterX.clear();
+		m_CenterY.clear();
+		m_CenterZ.clear();
+		m_ExtentX.clear();
+		m_ExtentY.clear();
+		m_ExtentZ.clear();
+	}
+
+	void FrustumCuller::AddBox(const Vector3& boundsMin, const Vector3& boundsMax)
+	{
+		const Vector3 center{ (boundsMin + boundsMax) * .5f };
+		const Vector3 extents{ (boundsMax - boundsMin) * .5f };
+
+		m_CenterX.emplace_back(center.x);
+		m_CenterY.emplace_back(center.y);
+		m_CenterZ.emplace_back(center.z);
+		m_ExtentX.emplace_back(extents.x);
+		m_ExtentY.emplace_back(extents.y);
+		m_ExtentZ.emplace_back(extents.z);
+	}
+
+	void FrustumCuller::Cull(const Frustum& frustum, std::vector<uint8_t>& isVisible) const
+	{
+		const size_t count{ GetCount() };
+		isVisible.resize(count);
+
+		// A box is outside when it lies entirely behind one of the planes: distance of the center + projected extents < 0
+		const __m256 signMask{ _mm256_set1_ps(-0.f) };
+
+		size_t i{ 0 };
+		for (; i + 8 <= count; i += 8)
+		{
+			const __m256 centerX{ _mm256_loadu_ps(m_CenterX.data() + i) };
+			const __m256 centerY{ _mm256_loadu_ps(m_CenterY.data() + i) };
+			const __m256 centerZ{ _mm256_loadu_ps(m_CenterZ.data() + i) };
+			const __m256 extentX{ _mm256_loadu_ps(m_ExtentX.data() + i) };
+			const __m256 extentY{ _mm256_loadu_ps(m_ExtentY.data() + i) };
+			const __m256 extentZ{ _mm256_loadu_ps(m_ExtentZ.data() + i) };
+
+			__m256 isOutside{ _mm256_setzero_ps() };
+			for (const Vector4& plane : frustum.planes)
+			{
+				const __m256 planeX{ _mm256_set1_ps(plane.x) };
+				const __m256 planeY{ _mm256_set1_ps(plane.y) };
+				const __m256 planeZ{ _mm256_set1_ps(plane.z) };
+
+				__m256 distance{ _mm256_fmadd_ps(planeX, centerX, _mm256_set1_ps(plane.w)) };
+				distance = _mm256_fmadd_ps(planeY, centerY, distance);
+				distance = _mm256_fmadd_ps(planeZ, centerZ, distance);
+
+				// |plane| dotted with the extents
+				distance = _mm256_fmadd_ps(_mm256_andnot_ps(signMask, planeX), extentX, distance);
+				distance = _mm256_fmadd_ps(_mm256_andnot_ps(signMask, planeY), extentY, distance);
+				distance = _mm256_fmadd_ps(_mm256_andnot_ps(signMask, planeZ), extentZ, distance);
+
+				isOutside = _mm256_or_ps(isOutside, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_LT_OQ));
+			}
+
+			const int outsideMask{ _mm256_movemask_ps(isOutside) };
+			for (int lane{ 0 }; lane < 8; ++lane)
+			{
+				isVisible[i + lane] = static_cast<uint8_t>(((outsideMask >> lane) & 1) ^ 1);
+			}
+		}
+
+		// Remaining boxes one by one
+		for (; i < count; ++i)
+		{
+			isVisible[i] = !frustum.IsBoxOutside({ m_CenterX[i], m_CenterY[i], m_CenterZ[i] }, { m_ExtentX[i], m_ExtentY[i], m_ExtentZ[i] });
+		}
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+namespace dae
+{
+	// Planes of a view frustum, the normals point inwards.
+	// A point p is inside when Dot(plane.xyz, p) + plane.w >= 0 holds for every plane.
+	struct Frustum
+	{
+		enum class Containment
+		{
+			Outside,
+			Intersecting,
+			Inside
+		};
+
+		Vector4 planes[6]{};
+
+		// Extracts the planes from a row vector view projection matrix with depth in [0, 1]
+		static Frustum FromViewProjection(const Matrix& viewProj);
+
+		bool IsBoxOutside(const Vector3& center, const Vector3& extents) const { return Classify(center, extents) == Containment::Outside; }
+		Containment Classify(const Vector3& center, const Vector3& extents) const;
+	};
+
+	// World space bounding boxes stored as a structure of arrays,
+	// so the culling tests eight boxes against a plane at once.
+	class FrustumCuller final
+	{
+	public:
+		FrustumCuller() = default;
+		~FrustumCuller() = default;
+
+		FrustumCuller(const FrustumCuller&) = delete;
+		FrustumCuller(FrustumCuller&&) noexcept = delete;
+		FrustumCuller& operator=(const FrustumCuller&) = delete;
+		FrustumCuller& operator=(FrustumCuller&&) noexcept = delete;
+
+		void Clear();
+		void AddBox(const Vector3& boundsMin, const Vector3& boundsMax);
+
+		// Writes 1 for every box that intersects the frustum and 0 for every box that is outside, in the order they were added
+		void Cull(const Frustum& frustum, std::vector<uint8_t>& isVisible) const;
+
+		size_t GetCount() const { return m_CenterX.size(); }
+
+	private:
+		std::vector<float> m_CenterX{};
+		std::vector<float> m_CenterY{};
+		std::vector<float> m_CenterZ{};
+		std::vector<float> m_ExtentX{};
+		std::vector<float> m_ExtentY{};
+		std::vector<float> m_ExtentZ{};
+	};
+}
@@ -0,0 +1,440 @@
+#include "pch.h"
+#include "GltfFile.h"
+
+#include <filesystem>
+
+#include "Utils.h"
+
+namespace dae
+{
+	bool GltfFile::Open(const std::string& path)
+	{
+		m_Path = path;
+		m_Primitives.clear();
+		m_Materials.clear();
+		m_Binary = {};
+
+		if (!m_File.Open(path))
+		{
+			std::cout << "GltfFile: failed to open " << path << '\n';
+			return false;
+		}
+
+		const uint8_t* pData{ m_File.GetData() };
+		const size_t fileSize{ m_File.GetSize() };
+
+		// [Header][JSON chunk][optional BIN chunk], chunks are 4 byte aligned
+		Header header{};
+		ChunkHeader jsonChunk{};
+		if (fileSize < sizeof(Header) + sizeof(ChunkHeader))
+		{
+			std::cout << "GltfFile: file too small: " << path << '\n';
+			return false;
+		}
+		std::memcpy(&header, pData, sizeof(Header));
+		std::memcpy(&jsonChunk, pData + sizeof(Header), sizeof(ChunkHeader));
+
+		const size_t jsonOffset{ sizeof(Header) + sizeof(ChunkHeader) };
+		if (header.magic != m_Magic || header.version != 2 || header.length > fileSize ||
+			jsonChunk.type != m_JsonChunk || jsonOffset + jsonChunk.length > header.length)
+		{
+			std::cout << "GltfFile: not a binary glTF 2.0 file: " << path << '\n';
+			return false;
+		}
+
+		const std::string_view json{ reinterpret_cast<const char*>(pData + jsonOffset), jsonChunk.length };
+		if (!JsonValue::Parse(json, m_Document))
+		{
+			std::cout << "GltfFile: invalid JSON chunk: " << path << '\n';
+			return false;
+		}
+
+		const size_t binaryHeaderOffset{ jsonOffset + ((jsonChunk.length + 3) & ~size_t{ 3 }) };
+		if (binaryHeaderOffset + sizeof(ChunkHeader) <= header.length)
+		{
+			ChunkHeader binaryChunk{};
+			std::memcpy(&binaryChunk, pData + binaryHeaderOffset, sizeof(ChunkHeader));
+
+			const size_t binaryOffset{ binaryHeaderOffset + sizeof(ChunkHeader) };
+			if (binaryChunk.type == m_BinaryChunk && binaryOffset + binaryChunk.length <= header.length)
+			{
+				m_Binary = { pData + binaryOffset, binaryChunk.length };
+			}
+		}
+
+		// Materials
+		const JsonValue& materials{ m_Document["materials"] };
+		for (size_t i{ 0 }; i < materials.GetSize(); ++i)
+		{
+			const JsonValue& pbr{ materials[i]["pbrMetallicRoughness"] };
+			const JsonValue& factor{ pbr["baseColorFactor"] };
+
+			Material material{};
+			material.baseColorTexture = pbr["baseColorTexture"]["index"].AsInt(-1);
+			material.normalTexture = materials[i]["normalTexture"]["index"].AsInt(-1);
+			if (factor.GetSize() >= 3)
+			{
+				material.baseColorFactor = { factor[0].AsFloat(1.f), factor[1].AsFloat(1.f), factor[2].AsFloat(1.f) };
+			}
+
+			m_Materials.emplace_back(material);
+		}
+
+		// Walk the node hierarchy of the default scene, or every root node when there are no scenes
+		const JsonValue& scenes{ m_Document["scenes"] };
+		if (scenes.GetSize() > 0)
+		{
+			const JsonValue& rootNodes{ scenes[m_Document["scene"].AsInt(0)]["nodes"] };
+			for (size_t i{ 0 }; i < rootNodes.GetSize(); ++i)
+			{
+				AddNode(rootNodes[i].AsInt(-1), Matrix{}, 0);
+			}
+		}
+		else
+		{
+			const JsonValue& nodes{ m_Document["nodes"] };
+
+			std::vector<bool> isChild(nodes.GetSize());
+			for (size_t i{ 0 }; i < nodes.GetSize(); ++i)
+			{
+				const JsonValue& children{ nodes[i]["children"] };
+				for (size_t child{ 0 }; child < children.GetSize(); ++child)
+				{
+					const int index{ children[child].AsInt(-1) };
+					if (index >= 0 && index < static_cast<int>(isChild.size())) isChild[index] = true;
+				}
+			}
+
+			for (size_t i{ 0 }; i < nodes.GetSize(); ++i)
+			{
+				if (!isChild[i]) AddNode(static_cast<int>(i), Matrix{}, 0);
+			}
+		}
+
+		if (m_Primitives.empty())
+		{
+			std::cout << "GltfFile: no triangle meshes in " << path << '\n';
+			return false;
+		}
+
+		return true;
+	}
+
+	bool GltfFile::ReadPrimitive(const Primitive& primitive, std::vector<Vertex_In>& vertices, std::vector<uint32_t>& indices, bool flipAxisAndWinding) const
+	{
+		vertices.clear();
+		indices.clear();
+
+		const AccessorView<Vector3> positions{ GetAccessor<Vector3>(primitive.positions, ComponentType::Float, 3) };
+		if (positions.IsEmpty())
+		{
+			std::cout << "GltfFile: primitive without float positions in " << m_Path << '\n';
+			return false;
+		}
+
+		const size_t vertexCount{ positions.count };
+
+		// Optional attributes are ignored when their count does not match the positions
+		const auto matchCount{ [vertexCount]<typename T>(const AccessorView<T>& view)
+			{
+				return view.count == vertexCount ? view : AccessorView<T>{};
+			} };
+
+		const AccessorView<Vector3> normals{ matchCount(GetAccessor<Vector3>(primitive.normals, ComponentType::Float, 3)) };
+		const AccessorView<Vector4> tangents{ matchCount(GetAccessor<Vector4>(primitive.tangents, ComponentType::Float, 4)) };
+		const AccessorView<Vector2> texCoords{ matchCount(GetAccessor<Vector2>(primitive.texCoords, ComponentType::Float, 2)) };
+		const AccessorView<Vector3> colorsRGB{ matchCount(GetAccessor<Vector3>(primitive.colors, ComponentType::Float, 3)) };
+		const AccessorView<Vector4> colorsRGBA{ matchCount(GetAccessor<Vector4>(primitive.colors, ComponentType::Float, 4)) };
+
+		const ColorRGB baseColor
+		{
+			primitive.material >= 0 && primitive.material < static_cast<int>(m_Materials.size()) ?
+			m_Materials[primitive.material].baseColorFactor : colors::White
+		};
+
+		// Normals need the inverse transpose when the node is scaled non uniformly
+		const Matrix& worldMatrix{ primitive.worldMatrix };
+		const Matrix normalMatrix{ Matrix::Transpose(Matrix::Inverse(worldMatrix)) };
+
+		vertices.resize(vertexCount);
+		for (size_t i{ 0 }; i < vertexCount; ++i)
+		{
+			Vertex_In& vertex{ vertices[i] };
+			vertex.pos = worldMatrix.TransformPoint(positions[i]);
+
+			if (!normals.IsEmpty()) vertex.norm = normalMatrix.TransformVector(normals[i]).Normalized();
+			if (!tangents.IsEmpty()) vertex.tan = worldMatrix.TransformVector(tangents[i].GetXYZ()).Normalized();
+			if (!texCoords.IsEmpty()) vertex.uv = texCoords[i];
+
+			vertex.col = baseColor;
+			if (!colorsRGB.IsEmpty()) vertex.col = { baseColor.r * colorsRGB[i].x, baseColor.g * colorsRGB[i].y, baseColor.b * colorsRGB[i].z };
+			if (!colorsRGBA.IsEmpty()) vertex.col = { baseColor.r * colorsRGBA[i].x, baseColor.g * colorsRGBA[i].y, baseColor.b * colorsRGBA[i].z };
+		}
+
+		if (primitive.indices < 0)
+		{
+			indices.resize(vertexCount - vertexCount % 3);
+			for (uint32_t i{ 0 }; i < indices.size(); ++i)
+			{
+				indices[i] = i;
+			}
+		}
+		else
+		{
+			bool isValid{ false };
+			switch (GetComponentType(primitive.indices))
+			{
+			case ComponentType::UnsignedByte:
+				isValid = ReadIndices<uint8_t>(primitive.indices, ComponentType::UnsignedByte, vertexCount, indices);
+				break;
+			case ComponentType::UnsignedShort:
+				isValid = ReadIndices<uint16_t>(primitive.indices, ComponentType::UnsignedShort, vertexCount, indices);
+				break;
+			case ComponentType::UnsignedInt:
+				isValid = ReadIndices<uint32_t>(primitive.indices, ComponentType::UnsignedInt, vertexCount, indices);
+				break;
+			default:
+				break;
+			}
+
+			if (!isValid)
+			{
+				std::cout << "GltfFile: invalid indices in " << m_Path << '\n';
+				return false;
+			}
+		}
+
+		// A mirroring node transform turns the winding around
+		const bool isMirrored{ Vector3::Dot(Vector3::Cross(worldMatrix.GetAxisX(), worldMatrix.GetAxisY()), worldMatrix.GetAxisZ()) < 0.f };
+		if (isMirrored)
+		{
+			for (size_t i{ 0 }; i < indices.size(); i += 3)
+			{
+				std::swap(indices[i + 1], indices[i + 2]);
+			}
+		}
+
+		// Flat normals weighted by area when the file has none
+		if (normals.IsEmpty())
+		{
+			for (size_t i{ 0 }; i < indices.size(); i += 3)
+			{
+				Vertex_In& v0{ vertices[indices[i]] };
+				Vertex_In& v1{ vertices[indices[i + 1]] };
+				Vertex_In& v2{ vertices[indices[i + 2]] };
+
+				const Vector3 normal{ Vector3::Cross(v1.pos - v0.pos, v2.pos - v0.pos) };
+				v0.norm += normal;
+				v1.norm += normal;
+				v2.norm += normal;
+			}
+
+			for (Vertex_In& vertex : vertices)
+			{
+				vertex.norm = vertex.norm.SqrMagnitude() > 0.f ? vertex.norm.Normalized() : Vector3::UnitY;
+			}
+		}
+
+		if (tangents.IsEmpty())
+		{
+			Utils::CalculateTangents(vertices, indices);
+		}
+
+		if (flipAxisAndWinding)
+		{
+			for (Vertex_In& vertex : vertices)
+			{
+				vertex.pos.z *= -1.f;
+				vertex.norm.z *= -1.f;
+				vertex.tan.z *= -1.f;
+			}
+
+			for (size_t i{ 0 }; i < indices.size(); i += 3)
+			{
+				std::swap(indices[i + 1], indices[i + 2]);
+			}
+		}
+
+		return true;
+	}
+
+	template <typename Index>
+	bool GltfFile::ReadIndices(int accessor, ComponentType componentType, size_t vertexCount, std::vector<uint32_t>& indices) const
+	{
+		const AccessorView<Index> view{ GetAccessor<Index>(accessor, componentType, 1) };
+		if (view.IsEmpty()) return false;
+
+		indices.reserve(view.count - view.count % 3);
+		for (size_t i{ 0 }; i + 2 < view.count; i += 3)
+		{
+			const uint32_t triangle[3]{ view[i], view[i + 1], view[i + 2] };
+			if (triangle[0] >= vertexCount || triangle[1] >= vertexCount || triangle[2] >= vertexCount) return false;
+
+			indices.insert(indices.end(), std::begin(triangle), std::end(triangle));
+		}
+
+		return true;
+	}
+
+	GltfFile::ComponentType GltfFile::GetComponentType(int accessor) const
+	{
+		return static_cast<ComponentType>(m_Document["accessors"][accessor]["componentType"].AsInt());
+	}
+
+	int GltfFile::GetComponentCount(int accessor) const
+	{
+		const std::string& type{ m_Document["accessors"][accessor]["type"].AsString() };
+
+		if (type == "SCALAR") return 1;
+		if (type == "VEC2") return 2;
+		if (type == "VEC3") return 3;
+		if (type == "VEC4") return 4;
+		return 0;
+	}
+
+	std::span<const uint8_t> GltfFile::GetTextureImage(int texture) const
+	{
+		const JsonValue& image{ m_Document["images"][m_Document["textures"][texture]["source"].AsInt(-1)] };
+		if (!image.Contains("bufferView")) return {};
+
+		const JsonValue& bufferView{ m_Document["bufferViews"][image["bufferView"].AsInt(-1)] };
+		const size_t size{ static_cast<size_t>(bufferView["byteLength"].AsNumber()) };
+
+		const uint8_t* pData{};
+		if (!ResolveBufferView(image["bufferView"].AsInt(-1), 0, size, pData)) return {};
+
+		return { pData, size };
+	}
+
+	std::string GltfFile::GetTextureUri(int texture) const
+	{
+		const JsonValue& image{ m_Document["images"][m_Document["textures"][texture]["source"].AsInt(-1)] };
+
+		// Data URIs are not supported, only files next to the glb
+		const std::string& uri{ image["uri"].AsString() };
+		if (uri.empty() || uri.starts_with("data:")) return {};
+
+		return (std::filesystem::path{ m_Path }.parent_path() / uri).string();
+	}
+
+	void GltfFile::AddNode(int node, const Matrix& parentMatrix, int depth)
+	{
+		const JsonValue& nodeValue{ m_Document["nodes"][node] };
+
+		// Also guards against cycles in broken files
+		static constexpr int maxDepth{ 64 };
+		if (!nodeValue.IsObject() || depth > maxDepth) return;
+
+		const Matrix worldMatrix{ GetNodeMatrix(nodeValue) * parentMatrix };
+
+		const JsonValue& primitives{ m_Document["meshes"][nodeValue["mesh"].AsInt(-1)]["primitives"] };
+		for (size_t i{ 0 }; i < primitives.GetSize(); ++i)
+		{
+			const JsonValue& primitive{ primitives[i] };
+			if (primitive["mode"].AsInt(m_TriangleMode) != m_TriangleMode) continue;
+
+			const JsonValue& attributes{ primitive["attributes"] };
+
+			Primitive result{};
+			result.positions = attributes["POSITION"].AsInt(-1);
+			result.normals = attributes["NORMAL"].AsInt(-1);
+			result.tangents = attributes["TANGENT"].AsInt(-1);
+			result.texCoords = attributes["TEXCOORD_0"].AsInt(-1);
+			result.colors = attributes["COLOR_0"].AsInt(-1);
+			result.indices = primitive["indices"].AsInt(-1);
+			result.material = primitive["material"].AsInt(-1);
+			result.worldMatrix = worldMatrix;
+
+			if (result.positions >= 0) m_Primitives.emplace_back(result);
+		}
+
+		const JsonValue& children{ nodeValue["children"] };
+		for (size_t i{ 0 }; i < children.GetSize(); ++i)
+		{
+			AddNode(children[i].AsInt(-1), worldMatrix, depth + 1);
+		}
+	}
+
+	Matrix GltfFile::GetNodeMatrix(const JsonValue& node)
+	{
+		// glTF stores column major matrices for column vectors, which is row major for row vectors
+		const JsonValue& matrix{ node["matrix"] };
+		if (matrix.GetSize() == 16)
+		{
+			Vector4 rows[4]{};
+			for (int row{ 0 }; row < 4; ++row)
+			{
+				rows[row] = { matrix[row * 4].AsFloat(), matrix[row * 4 + 1].AsFloat(), matrix[row * 4 + 2].AsFloat(), matrix[row * 4 + 3].AsFloat() };
+			}
+			return Matrix{ rows[0], rows[1], rows[2], rows[3] };
+		}
+
+		const JsonValue& translation{ node["translation"] };
+		const JsonValue& rotation{ node["rotation"] };
+		const JsonValue& scale{ node["scale"] };
+
+		const Vector3 t{ translation[0].AsFloat(), translation[1].AsFloat(), translation[2].AsFloat() };
+		const Vector3 s{ scale[0].AsFloat(1.f), scale[1].AsFloat(1.f), scale[2].AsFloat(1.f) };
+
+		// Unit quaternion (x, y, z, w) to a rotation matrix for row vectors
+		const float x{ rotation[0].AsFloat() };
+		const float y{ rotation[1].AsFloat() };
+		const float z{ rotation[2].AsFloat() };
+		const float w{ rotation[3].AsFloat(1.f) };
+
+		const Matrix rotationMatrix
+		{
+			{ 1.f - 2.f * (y * y + z * z), 2.f * (x * y + z * w), 2.f * (x * z - y * w) },
+			{ 2.f * (x * y - z * w), 1.f - 2.f * (x * x + z * z), 2.f * (y * z + x * w) },
+			{ 2.f * (x * z + y * w), 2.f * (y * z - x * w), 1.f - 2.f * (x * x + y * y) },
+			Vector3::Zero
+		};
+
+		return Matrix::CreateScale(s) * rotationMatrix * Matrix::CreateTranslation(t);
+	}
+
+	bool GltfFile::ResolveBufferView(int bufferView, size_t offset, size_t size, const uint8_t*& pData) const
+	{
+		const JsonValue& view{ m_Document["bufferViews"][bufferView] };
+
+		// Only the binary chunk of the glb is supported, not external .bin files
+		if (!view.IsObject() || view["buffer"].AsInt() != 0 || view["uri"].AsString().size() > 0) return false;
+
+		const size_t viewOffset{ static_cast<size_t>(view["byteOffset"].AsNumber()) };
+		const size_t viewLength{ static_cast<size_t>(view["byteLength"].AsNumber()) };
+		if (offset + size > viewLength || viewOffset + viewLength > m_Binary.size()) return false;
+
+		pData = m_Binary.data() + viewOffset + offset;
+		return true;
+	}
+
+	bool GltfFile::ResolveAccessor(int accessor, ComponentType componentType, int nrComponents, size_t elementSize, const uint8_t*& pData, size_t& count, size_t& stride) const
+	{
+		const JsonValue& accessorValue{ m_Document["accessors"][accessor] };
+		if (!accessorValue.IsObject()) return false;
+
+		if (GetComponentType(accessor) != componentType || GetComponentCount(accessor) != nrComponents) return false;
+
+		// Sparse accessors and accessors without a buffer view would need a copy, which defeats the purpose
+		if (accessorValue.Contains("sparse") || !accessorValue.Contains("bufferView"))
+		{
+			std::cout << "GltfFile: unsupported accessor " << accessor << " in " << m_Path << '\n';
+			return false;
+		}
+
+		const int bufferView{ accessorValue["bufferView"].AsInt(-1) };
+		const size_t byteStride{ static_cast<size_t>(m_Document["bufferViews"][bufferView]["byteStride"].AsNumber()) };
+
+		count = static_cast<size_t>(accessorValue["count"].AsNumber());
+		stride = byteStride != 0 ? byteStride : elementSize;
+		if (count == 0) return false;
+
+		const size_t offset{ static_cast<size_t>(accessorValue["byteOffset"].AsNumber()) };
+		const size_t size{ (count - 1) * stride + elementSize };
+		if (!ResolveBufferView(bufferView, offset, size, pData)) return false;
+
+		// Elements are read in place, so they have to be aligned to their components
+		const size_t alignment{ elementSize % 4 == 0 ? 4 : elementSize % 2 == 0 ? 2 : 1 };
+		return reinterpret_cast<uintptr_t>(pData) % alignment == 0 && stride % alignment == 0;
+	}
+}
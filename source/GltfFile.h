@@ -0,0 +1,140 @@
+#pragma once
+#include <span>
+
+#include "DataTypes.h"
+#include "Json.h"
+#include "MappedFile.h"
+
+namespace dae
+{
+	// Binary glTF 2.0 (.glb) file.
+	// The file stays memory mapped, accessors are returned as views straight into the binary chunk.
+	class GltfFile final
+	{
+	public:
+		// View of the elements of an accessor, stride is the distance between two elements in bytes
+		template <typename T>
+		struct AccessorView
+		{
+			const uint8_t* pData{ nullptr };
+			size_t count{};
+			size_t stride{ sizeof(T) };
+
+			bool IsEmpty() const { return count == 0; }
+			bool IsTightlyPacked() const { return stride == sizeof(T); }
+			std::span<const T> AsSpan() const { return IsTightlyPacked() ? std::span<const T>{ reinterpret_cast<const T*>(pData), count } : std::span<const T>{}; }
+
+			const T& operator[](size_t index) const { return *reinterpret_cast<const T*>(pData + index * stride); }
+		};
+
+		// Triangle list of a mesh as instanced by a node, -1 marks a missing accessor
+		struct Primitive
+		{
+			int positions{ -1 };
+			int normals{ -1 };
+			int tangents{ -1 };
+			int texCoords{ -1 };
+			int colors{ -1 };
+			int indices{ -1 };
+			int material{ -1 };
+
+			// Transform of the node in the glTF (right handed) coordinate system
+			Matrix worldMatrix{};
+		};
+
+		// Only the textures the shaders can use, -1 marks a missing texture
+		struct Material
+		{
+			int baseColorTexture{ -1 };
+			int normalTexture{ -1 };
+			ColorRGB baseColorFactor{ colors::White };
+		};
+
+		enum class ComponentType
+		{
+			Byte = 5120,
+			UnsignedByte = 5121,
+			Short = 5122,
+			UnsignedShort = 5123,
+			UnsignedInt = 5125,
+			Float = 5126
+		};
+
+		GltfFile() = default;
+		~GltfFile() = default;
+
+		GltfFile(const GltfFile&) = delete;
+		GltfFile(GltfFile&&) noexcept = delete;
+		GltfFile& operator=(const GltfFile&) = delete;
+		GltfFile& operator=(GltfFile&&) noexcept = delete;
+
+		bool Open(const std::string& path);
+
+		// Returns an empty view when the accessor does not exist, or its components or type do not match T
+		template <typename T>
+		AccessorView<T> GetAccessor(int accessor, ComponentType componentType, int nrComponents) const
+		{
+			const uint8_t* pData{};
+			size_t count{};
+			size_t stride{};
+			if (!ResolveAccessor(accessor, componentType, nrComponents, sizeof(T), pData, count, stride)) return {};
+
+			return AccessorView<T>{ pData, count, stride };
+		}
+
+		// Builds the vertices and indices of a primitive with the node transform applied.
+		// Missing normals and tangents are generated, like ParseOBJ the result is converted to left handed coordinates.
+		bool ReadPrimitive(const Primitive& primitive, std::vector<Vertex_In>& vertices, std::vector<uint32_t>& indices, bool flipAxisAndWinding = true) const;
+
+		ComponentType GetComponentType(int accessor) const;
+		int GetComponentCount(int accessor) const;
+
+		// Embedded image data of a texture, empty when the image is stored as a separate file
+		std::span<const uint8_t> GetTextureImage(int texture) const;
+		// Path of an external texture image, relative to the working directory
+		std::string GetTextureUri(int texture) const;
+
+		// Getters
+		const std::vector<Primitive>& GetPrimitives() const { return m_Primitives; }
+		const std::vector<Material>& GetMaterials() const { return m_Materials; }
+		const std::string& GetPath() const { return m_Path; }
+
+	private:
+		struct ChunkHeader
+		{
+			uint32_t length{};
+			uint32_t type{};
+		};
+
+		struct Header
+		{
+			uint32_t magic{};
+			uint32_t version{};
+			uint32_t length{};
+		};
+
+		static constexpr uint32_t m_Magic{ 0x46546C67 }; // "glTF"
+		static constexpr uint32_t m_JsonChunk{ 0x4E4F534A }; // "JSON"
+		static constexpr uint32_t m_BinaryChunk{ 0x004E4942 }; // "BIN\0"
+
+		static constexpr int m_TriangleMode{ 4 };
+
+		MappedFile m_File{};
+		std::string m_Path{};
+
+		JsonValue m_Document{};
+		std::span<const uint8_t> m_Binary{};
+
+		std::vector<Primitive> m_Primitives{};
+		std::vector<Material> m_Materials{};
+
+		void AddNode(int node, const Matrix& parentMatrix, int depth);
+		static Matrix GetNodeMatrix(const JsonValue& node);
+
+		template <typename Index>
+		bool ReadIndices(int accessor, ComponentType componentType, size_t vertexCount, std::vector<uint32_t>& indices) const;
+
+		bool ResolveBufferView(int bufferView, size_t offset, size_t size, const uint8_t*& pData) const;
+		bool ResolveAccessor(int accessor, ComponentType componentType, int nrComponents, size_t elementSize, const uint8_t*& pData, size_t& count, size_t& stride) const;
+	};
+}
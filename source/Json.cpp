@@ -0,0 +1,273 @@
+#include "pch.h"
+#include "Json.h"
+
+#include <charconv>
+
+namespace dae
+{
+	// Recursive descent parser over the whole text
+	class JsonValue::Parser final
+	{
+	public:
+		explicit Parser(std::string_view text)
+			: m_Text{ text }
+		{
+		}
+
+		bool ParseDocument(JsonValue& value)
+		{
+			if (!ParseValue(value, 0)) return false;
+
+			SkipWhitespace();
+			return m_Position == m_Text.size();
+		}
+
+		size_t GetPosition() const { return m_Position; }
+
+	private:
+		std::string_view m_Text;
+		size_t m_Position{ 0 };
+
+		// Guards against stack overflows on malicious input
+		static constexpr int m_MaxDepth{ 256 };
+
+		void SkipWhitespace()
+		{
+			while (m_Position < m_Text.size() && (m_Text[m_Position] == ' ' || m_Text[m_Position] == '\t' || m_Text[m_Position] == '\n' || m_Text[m_Position] == '\r'))
+			{
+				++m_Position;
+			}
+		}
+
+		bool Consume(char c)
+		{
+			SkipWhitespace();
+			if (m_Position >= m_Text.size() || m_Text[m_Position] != c) return false;
+
+			++m_Position;
+			return true;
+		}
+
+		bool ConsumeLiteral(std::string_view literal)
+		{
+			if (m_Text.substr(m_Position, literal.size()) != literal) return false;
+
+			m_Position += literal.size();
+			return true;
+		}
+
+		bool ParseValue(JsonValue& value, int depth)
+		{
+			if (depth > m_MaxDepth) return false;
+
+			SkipWhitespace();
+			if (m_Position >= m_Text.size()) return false;
+
+			switch (m_Text[m_Position])
+			{
+			case '{':
+				return ParseObject(value, depth);
+			case '[':
+				return ParseArray(value, depth);
+			case '"':
+				value.m_Type = Type::String;
+				return ParseString(value.m_String);
+			case 't':
+				value.m_Type = Type::Bool;
+				value.m_Bool = true;
+				return ConsumeLiteral("true");
+			case 'f':
+				value.m_Type = Type::Bool;
+				value.m_Bool = false;
+				return ConsumeLiteral("false");
+			case 'n':
+				value.m_Type = Type::Null;
+				return ConsumeLiteral("null");
+			default:
+				value.m_Type = Type::Number;
+				return ParseNumber(value.m_Number);
+			}
+		}
+
+		bool ParseObject(JsonValue& value, int depth)
+		{
+			value.m_Type = Type::Object;
+			++m_Position;
+
+			if (Consume('}')) return true;
+
+			do
+			{
+				SkipWhitespace();
+
+				std::string key{};
+				if (m_Position >= m_Text.size() || m_Text[m_Position] != '"' || !ParseString(key)) return false;
+				if (!Consume(':')) return false;
+
+				JsonValue member{};
+				if (!ParseValue(member, depth + 1)) return false;
+
+				value.m_Keys.emplace_back(std::move(key));
+				value.m_Values.emplace_back(std::move(member));
+			} while (Consume(','));
+
+			return Consume('}');
+		}
+
+		bool ParseArray(JsonValue& value, int depth)
+		{
+			value.m_Type = Type::Array;
+			++m_Position;
+
+			if (Consume(']')) return true;
+
+			do
+			{
+				JsonValue element{};
+				if (!ParseValue(element, depth + 1)) return false;
+
+				value.m_Values.emplace_back(std::move(element));
+			} while (Consume(','));
+
+			return Consume(']');
+		}
+
+		bool ParseNumber(double& number)
+		{
+			const char* pFirst{ m_Text.data() + m_Position };
+			const char* pLast{ m_Text.data() + m_Text.size() };
+
+			const auto [pEnd, error] { std::from_chars(pFirst, pLast, number) };
+			if (error != std::errc{} || pEnd == pFirst) return false;
+
+			m_Position += pEnd - pFirst;
+			return true;
+		}
+
+		bool ParseHex4(uint32_t& codePoint)
+		{
+			if (m_Position + 4 > m_Text.size()) return false;
+
+			const auto [pEnd, error] { std::from_chars(m_Text.data() + m_Position, m_Text.data() + m_Position + 4, codePoint, 16) };
+			if (error != std::errc{} || pEnd != m_Text.data() + m_Position + 4) return false;
+
+			m_Position += 4;
+			return true;
+		}
+
+		static void AppendUtf8(std::string& string, uint32_t codePoint)
+		{
+			if (codePoint < 0x80)
+			{
+				string += static_cast<char>(codePoint);
+			}
+			else if (codePoint < 0x800)
+			{
+				string += static_cast<char>(0xC0 | (codePoint >> 6));
+				string += static_cast<char>(0x80 | (codePoint & 0x3F));
+			}
+			else if (codePoint < 0x10000)
+			{
+				string += static_cast<char>(0xE0 | (codePoint >> 12));
+				string += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+				string += static_cast<char>(0x80 | (codePoint & 0x3F));
+			}
+			else
+			{
+				string += static_cast<char>(0xF0 | (codePoint >> 18));
+				string += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+				string += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+				string += static_cast<char>(0x80 | (codePoint & 0x3F));
+			}
+		}
+
+		bool ParseString(std::string& string)
+		{
+			// Skip the opening quote
+			++m_Position;
+
+			while (m_Position < m_Text.size())
+			{
+				const char c{ m_Text[m_Position++] };
+				if (c == '"') return true;
+
+				if (c != '\\')
+				{
+					string += c;
+					continue;
+				}
+
+				if (m_Position >= m_Text.size()) return false;
+
+				switch (m_Text[m_Position++])
+				{
+				case '"': string += '"'; break;
+				case '\\': string += '\\'; break;
+				case '/': string += '/'; break;
+				case 'b': string += '\b'; break;
+				case 'f': string += '\f'; break;
+				case 'n': string += '\n'; break;
+				case 'r': string += '\r'; break;
+				case 't': string += '\t'; break;
+				case 'u':
+				{
+					uint32_t codePoint{};
+					if (!ParseHex4(codePoint)) return false;
+
+					// Characters outside the basic plane are written as a surrogate pair
+					if (codePoint >= 0xD800 && codePoint < 0xDC00)
+					{
+						uint32_t low{};
+						if (!ConsumeLiteral("\\u") || !ParseHex4(low) || low < 0xDC00 || low >= 0xE000) return false;
+
+						codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+					}
+
+					AppendUtf8(string, codePoint);
+					break;
+				}
+				default:
+					return false;
+				}
+			}
+
+			return false;
+		}
+	};
+
+	bool JsonValue::Parse(std::string_view text, JsonValue& value)
+	{
+		value = JsonValue{};
+
+		Parser parser{ text };
+		if (parser.ParseDocument(value)) return true;
+
+		std::cout << "JsonValue: parse error at offset " << parser.GetPosition() << '\n';
+		value = JsonValue{};
+		return false;
+	}
+
+	const JsonValue& JsonValue::operator[](size_t index) const
+	{
+		static const JsonValue null{};
+		return m_Type == Type::Array && index < m_Values.size() ? m_Values[index] : null;
+	}
+
+	const JsonValue& JsonValue::operator[](std::string_view key) const
+	{
+		static const JsonValue null{};
+		if (m_Type != Type::Object) return null;
+
+		for (size_t i{ 0 }; i < m_Keys.size(); ++i)
+		{
+			if (m_Keys[i] == key) return m_Values[i];
+		}
+
+		return null;
+	}
+
+	bool JsonValue::Contains(std::string_view key) const
+	{
+		return m_Type == Type::Object && std::ranges::find(m_Keys, key) != m_Keys.end();
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <string_view>
+
+namespace dae
+{
+	// Minimal JSON document, enough for glTF headers and scene files
+	class JsonValue final
+	{
+	public:
+		enum class Type
+		{
+			Null,
+			Bool,
+			Number,
+			String,
+			Array,
+			Object
+		};
+
+		JsonValue() = default;
+
+		// Returns false and prints the offset of the error when the text is not valid JSON
+		static bool Parse(std::string_view text, JsonValue& value);
+
+		// Getters, missing members and wrong types return the fallback or an empty value
+		Type GetType() const { return m_Type; }
+		bool IsNull() const { return m_Type == Type::Null; }
+		bool IsArray() const { return m_Type == Type::Array; }
+		bool IsObject() const { return m_Type == Type::Object; }
+
+		bool AsBool(bool fallback = false) const { return m_Type == Type::Bool ? m_Bool : fallback; }
+		double AsNumber(double fallback = 0.) const { return m_Type == Type::Number ? m_Number : fallback; }
+		float AsFloat(float fallback = 0.f) const { return static_cast<float>(AsNumber(fallback)); }
+		int AsInt(int fallback = 0) const { return m_Type == Type::Number ? static_cast<int>(m_Number) : fallback; }
+		const std::string& AsString() const { return m_String; }
+
+		size_t GetSize() const { return m_Values.size(); }
+		const JsonValue& operator[](size_t index) const;
+		const JsonValue& operator[](std::string_view key) const;
+		bool Contains(std::string_view key) const;
+
+		// Object members in the order they appear in the document
+		const std::vector<std::string>& GetKeys() const { return m_Keys; }
+		const std::vector<JsonValue>& GetValues() const { return m_Values; }
+
+	private:
+		Type m_Type{ Type::Null };
+		bool m_Bool{};
+		double m_Number{};
+		std::string m_String{};
+
+		// Elements of an array, or values of an object with their keys in m_Keys
+		std::vector<std::string> m_Keys{};
+		std::vector<JsonValue> m_Values{};
+
+		class Parser;
+	};
+}
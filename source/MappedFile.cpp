@@ -0,0 +1,66 @@
+#include "pch.h"
+#include "MappedFile.h"
+
+namespace dae
+{
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+	bool MappedFile::Open(const std::string& path)
+	{
+		Close();
+
+		m_hFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (m_hFile == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER fileSize{};
+		if (!GetFileSizeEx(m_hFile, &fileSize) || fileSize.QuadPart == 0)
+		{
+			Close();
+			return false;
+		}
+
+		m_hMapping = CreateFileMappingA(m_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!m_hMapping)
+		{
+			Close();
+			return false;
+		}
+
+		m_pData = static_cast<const uint8_t*>(MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0));
+		if (!m_pData)
+		{
+			Close();
+			return false;
+		}
+
+		m_Size = static_cast<size_t>(fileSize.QuadPart);
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (m_pData)
+		{
+			UnmapViewOfFile(m_pData);
+			m_pData = nullptr;
+		}
+
+		if (m_hMapping)
+		{
+			CloseHandle(m_hMapping);
+			m_hMapping = nullptr;
+		}
+
+		if (m_hFile != INVALID_HANDLE_VALUE)
+		{
+			CloseHandle(m_hFile);
+			m_hFile = INVALID_HANDLE_VALUE;
+		}
+
+		m_Size = 0;
+	}
+}
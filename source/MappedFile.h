@@ -0,0 +1,32 @@
+#pragma once
+
+namespace dae
+{
+	// Read-only memory mapped view of a file
+	class MappedFile final
+	{
+	public:
+		MappedFile() = default;
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile(MappedFile&&) noexcept = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		MappedFile& operator=(MappedFile&&) noexcept = delete;
+
+		bool Open(const std::string& path);
+		void Close();
+
+		// Getters
+		bool IsOpen() const { return m_pData != nullptr; }
+		const uint8_t* GetData() const { return m_pData; }
+		size_t GetSize() const { return m_Size; }
+
+	private:
+		HANDLE m_hFile{ INVALID_HANDLE_VALUE };
+		HANDLE m_hMapping{ nullptr };
+
+		const uint8_t* m_pData{ nullptr };
+		size_t m_Size{};
+	};
+}
@@ -268,6 +268,19 @@ namespace dae {
 		return data[index];
 	}
 
+	bool Matrix::operator==(const Matrix& m) const
+	{
+		for (int r{ 0 }; r < 4; ++r)
+		{
+			for (int c{ 0 }; c < 4; ++c)
+			{
+				if (data[r][c] != m.data[r][c]) return false;
+			}
+		}
+
+		return true;
+	}
+
 	Matrix Matrix::operator*(const Matrix& m) const
 	{
 		Matrix result{};
@@ -3,6 +3,7 @@
 
 #include "Effect.h"
 #include "DataTypes.h"
+#include "MeshSimplifier.h"
 
 namespace dae
 {
@@ -112,19 +113,65 @@ namespace dae
 		//4. Set index buffer
 		pDeviceContext->IASetIndexBuffer(m_pIndexBuffer, DXGI_FORMAT_R32_UINT, 0);
 
-		//5. Draw
+		//5. Draw every instance, the buffers stay bound and only the matrices change
 		D3DX11_TECHNIQUE_DESC techDesc{};
 		m_pEffect->GetTechnique()->GetDesc(&techDesc);
-		for (UINT p{ 0 }; p < techDesc.Passes; ++p)
+		for (size_t i{ 0 }; i < m_Instances.size(); ++i)
 		{
-			m_pEffect->GetTechnique()->GetPassByIndex(p)->Apply(0, pDeviceContext);
-			pDeviceContext->DrawIndexed(m_NumIndices, 0, 0);
+			const Matrix worldMatrix{ GetInstanceWorldMatrix(i) };
+			m_pEffect->SetMatrices(worldMatrix, worldMatrix * m_ViewProjMatrix, m_InvViewMatrix);
+
+			for (UINT p{ 0 }; p < techDesc.Passes; ++p)
+			{
+				m_pEffect->GetTechnique()->GetPassByIndex(p)->Apply(0, pDeviceContext);
+				pDeviceContext->DrawIndexed(m_NumIndices, 0, 0);
+			}
 		}
 	}
 
 	void Mesh::RotateY(const float degrees)
 	{
 		m_WorldMatrix = Matrix::CreateRotationY(degrees * TO_RADIANS) * m_WorldMatrix;
+		++m_TransformVersion;
+	}
+
+	float Mesh::IntersectRay(const Vector3& origin, const Vector3& direction, float maxDistance) const
+	{
+		const std::vector<Vertex_In>& vertices{ GetVertices() };
+		const std::vector<uint32_t>& indices{ GetIndices() };
+
+		const bool isTriangleList{ m_PrimitiveTopology == PrimitiveTopology::TriangleList };
+		const size_t increment{ isTriangleList ? 3u : 1u };
+		const size_t size{ isTriangleList ? indices.size() : (indices.size() >= 2 ? indices.size() - 2 : 0) };
+
+		float closest{ FLT_MAX };
+		for (size_t i{ 0 }; i + 2 < indices.size() && i < size; i += increment)
+		{
+			const Vector3& v0{ vertices[indices[i]].pos };
+			const Vector3& v1{ vertices[indices[i + 1]].pos };
+			const Vector3& v2{ vertices[indices[i + 2]].pos };
+
+			// Moller-Trumbore, both sides of the triangle count as a hit
+			const Vector3 edge1{ v1 - v0 };
+			const Vector3 edge2{ v2 - v0 };
+			const Vector3 p{ Vector3::Cross(direction, edge2) };
+			const float determinant{ Vector3::Dot(edge1, p) };
+			if (std::abs(determinant) < FLT_EPSILON) continue;
+
+			const float inverseDeterminant{ 1.f / determinant };
+			const Vector3 t{ origin - v0 };
+			const float u{ Vector3::Dot(t, p) * inverseDeterminant };
+			if (u < 0.f || u > 1.f) continue;
+
+			const Vector3 q{ Vector3::Cross(t, edge1) };
+			const float v{ Vector3::Dot(direction, q) * inverseDeterminant };
+			if (v < 0.f || u + v > 1.f) continue;
+
+			const float distance{ Vector3::Dot(edge2, q) * inverseDeterminant };
+			if (distance >= 0.f && distance < maxDistance && distance < closest) closest = distance;
+		}
+
+		return closest;
 	}
 
 	const char* Mesh::CycleTechniques()
@@ -142,49 +189,115 @@ namespace dae
 
 	void Mesh::SetMatrices(const Matrix& viewProj, const Matrix& invView)
 	{
+		// Applied per instance in Render
 		m_ViewProjMatrix = viewProj;
-		m_pEffect->SetMatrices(m_WorldMatrix, m_WorldMatrix * viewProj, invView);
+		m_InvViewMatrix = invView;
 	}
 
 	void Mesh::SetPosition(const Vector3& position)
 	{
 		m_WorldMatrix = Matrix::CreateTranslation(position);
+		++m_TransformVersion;
 	}
 
 	void Mesh::SetVertices(const std::vector<Vertex_In>& vertices)
 	{
-		m_Vertices.reserve(vertices.size());
-		m_VerticesOut.reserve(vertices.size());
+		MeshLod& lod{ m_Lods.front() };
+		lod.vertices.reserve(vertices.size());
+
+		std::ranges::copy(vertices.begin(), vertices.end(), std::back_inserter(lod.vertices));
+
+		// Bounding box, and a bounding sphere around its center
+		if (vertices.empty()) return;
+
+		m_BoundsMin = vertices.front().pos;
+		m_BoundsMax = vertices.front().pos;
+		for (const Vertex_In& vertex : vertices)
+		{
+			for (int axis{ 0 }; axis < 3; ++axis)
+			{
+				m_BoundsMin[axis] = std::min(m_BoundsMin[axis], vertex.pos[axis]);
+				m_BoundsMax[axis] = std::max(m_BoundsMax[axis], vertex.pos[axis]);
+			}
+		}
+
+		m_BoundingSphereCenter = (m_BoundsMin + m_BoundsMax) * .5f;
+		m_BoundingSphereRadius = 0.f;
+		for (const Vertex_In& vertex : vertices)
+		{
+			m_BoundingSphereRadius = std::max(m_BoundingSphereRadius, (vertex.pos - m_BoundingSphereCenter).Magnitude());
+		}
+	}
+
+	void Mesh::BuildLods()
+	{
+		// Only triangle lists can be simplified
+		if (m_PrimitiveTopology != PrimitiveTopology::TriangleList) return;
+
+		m_Lods.resize(1);
+		while (m_Lods.size() < m_MaxLods)
+		{
+			const MeshLod& previous{ m_Lods.back() };
+
+			const size_t targetIndexCount{ previous.indices.size() / 6 * 3 };
+			if (targetIndexCount < m_MinLodTriangles * 3) break;
+
+			float error{};
+			std::vector<uint32_t> indices{ MeshSimplifier::Simplify(previous.vertices, previous.indices, targetIndexCount, error) };
 
-		std::ranges::copy(vertices.begin(), vertices.end(), std::back_inserter(m_Vertices));
+			// Stop once the simplifier gets stuck, the LOD would barely be cheaper than the previous one
+			if (indices.size() > previous.indices.size() * 3 / 4) break;
 
-		for (const auto& vertex : m_Vertices)
+			MeshLod lod{};
+			lod.error = previous.error + error;
+
+			// Only keep the vertices that are still referenced
+			std::vector<uint32_t> vertexRemap(previous.vertices.size(), UINT32_MAX);
+			for (uint32_t& index : indices)
+			{
+				if (vertexRemap[index] == UINT32_MAX)
+				{
+					vertexRemap[index] = static_cast<uint32_t>(lod.vertices.size());
+
+					lod.vertices.emplace_back(previous.vertices[index]);
+				}
+				index = vertexRemap[index];
+			}
+			lod.indices = std::move(indices);
+
+			m_Lods.emplace_back(std::move(lod));
+		}
+	}
+
+	void Mesh::Compress()
+	{
+		for (MeshLod& lod : m_Lods)
 		{
-			m_VerticesOut.emplace_back(Vertex_Out{ {}, vertex.norm, vertex.tan, vertex.uv, vertex.col });
+			lod.compactVertices = VertexCompression::Compress(lod.vertices, lod.indices);
 		}
 	}
 
 	void Mesh::SetDiffuse(const Texture* diffuse)
 	{
 		m_pEffect->SetDiffuse(diffuse);
-		m_pDiffuse = diffuse;
+		m_Material.pDiffuse = diffuse;
 	}
 
 	void Mesh::SetNormal(const Texture* normal)
 	{
 		m_pEffect->SetNormal(normal);
-		m_pNormal = normal;
+		m_Material.pNormal = normal;
 	}
 
 	void Mesh::SetGloss(const Texture* gloss)
 	{
 		m_pEffect->SetGloss(gloss);
-		m_pGloss = gloss;
+		m_Material.pGloss = gloss;
 	}
 
 	void Mesh::SetSpecular(const Texture* specular)
 	{
 		m_pEffect->SetSpecular(specular);
-		m_pSpecular = specular;
+		m_Material.pSpecular = specular;
 	}
 }
@@ -1,16 +1,28 @@
 #pragma once
 
 #include "DataTypes.h"
+#include "VertexCompression.h"
 
 namespace dae
 {
 	class Effect;
 	struct Vertex_In;
-	struct Vertex_Out;
 	struct Material;
 
 	class Texture;
 
+	// Level of detail of the software mesh, LOD 0 is the original geometry
+	struct MeshLod
+	{
+		std::vector<Vertex_In> vertices{};
+		std::vector<uint32_t> indices{};
+		CompactVertices compactVertices{};
+
+		// Estimated object space deviation from the original surface, the summed quadric errors of the simplifications up to this LOD.
+		// Scaled to pixels it is compared against the pixel error threshold, a deviation estimate rather than a strict bound.
+		float error{};
+	};
+
 	class Mesh
 	{
 	public:
@@ -29,26 +41,49 @@ namespace dae
 
 		bool ToggleVisibility() { m_Visible = !m_Visible; return m_Visible; }
 
+		// Distance along an object space ray to the nearest triangle of LOD 0, FLT_MAX when nothing is hit within maxDistance
+		float IntersectRay(const Vector3& origin, const Vector3& direction, float maxDistance) const;
+
 		// Getters
-		std::vector<Vertex_Out>& GetVerticesOut() { return m_VerticesOut; }
-		const std::vector <Vertex_Out>& GetVerticesOut() const { return m_VerticesOut; }
-		const std::vector<uint32_t>& GetIndices() const { return m_Indices; }
-		const std::vector<Vertex_In>& GetVertices() const { return m_Vertices; }
+		const std::vector<uint32_t>& GetIndices() const { return m_Lods.front().indices; }
+		const std::vector<Vertex_In>& GetVertices() const { return m_Lods.front().vertices; }
+		MeshLod& GetLod(int lod) { return m_Lods[lod]; }
+		const MeshLod& GetLod(int lod) const { return m_Lods[lod]; }
+		int GetLodCount() const { return static_cast<int>(m_Lods.size()); }
+		const Vector3& GetBoundsMin() const { return m_BoundsMin; }
+		const Vector3& GetBoundsMax() const { return m_BoundsMax; }
+		const Vector3& GetBoundingSphereCenter() const { return m_BoundingSphereCenter; }
+		float GetBoundingSphereRadius() const { return m_BoundingSphereRadius; }
 		const Matrix& GetWorldMatrix() const { return m_WorldMatrix; }
+		const std::vector<Matrix>& GetInstances() const { return m_Instances; }
+		// Changes whenever the world matrix or the instances change, so spatial structures know when to refit
+		uint32_t GetTransformVersion() const { return m_TransformVersion; }
+		size_t GetInstanceCount() const { return m_Instances.size(); }
+		// The world matrix of the mesh is applied first, so RotateY spins every instance around its own origin
+		Matrix GetInstanceWorldMatrix(size_t instance) const { return m_WorldMatrix * m_Instances[instance]; }
 		const Matrix& GetViewProjMatrix() const { return m_ViewProjMatrix; }
 		PrimitiveTopology GetPrimitiveTopology() const { return m_PrimitiveTopology; }
+		ShadingRate GetShadingRate() const { return m_ShadingRate; }
 
 		// Texture Getters
-		const Texture* GetDiffuse() const { return m_pDiffuse; }
-		const Texture* GetSpecular() const { return m_pSpecular; }
-		const Texture* GetNormal() const { return m_pNormal; }
-		const Texture* GetGloss() const { return m_pGloss; }
+		const Texture* GetDiffuse() const { return m_Material.pDiffuse; }
+		const Texture* GetSpecular() const { return m_Material.pSpecular; }
+		const Texture* GetNormal() const { return m_Material.pNormal; }
+		const Texture* GetGloss() const { return m_Material.pGloss; }
+		const Material& GetMaterial() const { return m_Material; }
 
 		// Setters
 		void SetMatrices(const Matrix& viewProj, const Matrix& invView);
 		void SetPosition(const Vector3& position);
+		void SetInstances(const std::vector<Matrix>& instances) { m_Instances = instances; ++m_TransformVersion; }
 		void SetVertices(const std::vector<Vertex_In>& vertices);
-		void SetIndices(const std::vector<uint32_t>& indices) { m_Indices = indices; }
+		void SetIndices(const std::vector<uint32_t>& indices) { m_Lods.front().indices = indices; }
+		void SetShadingRate(ShadingRate shadingRate) { m_ShadingRate = shadingRate; }
+
+		// Simplifies the mesh into a chain of LODs, each with about half the triangles of the previous one
+		void BuildLods();
+		// Builds the compact copy of the vertices and indices of every LOD, used by the software rasterizer
+		void Compress();
 
 		void SetDiffuse(const Texture* diffuse);
 		void SetNormal(const Texture* normal);
@@ -66,19 +101,30 @@ namespace dae
 
 		Matrix m_WorldMatrix{};
 		Matrix m_ViewProjMatrix{};
+		Matrix m_InvViewMatrix{};
+
+		// Placement of every copy of the mesh, the geometry and textures are shared
+		std::vector<Matrix> m_Instances{ Matrix{} };
+		uint32_t m_TransformVersion{ 0 };
 
 		int m_TechniqueIndex{ 0 };
 		bool m_Visible{ true };
 
-		const Texture* m_pDiffuse{};
-		const Texture* m_pNormal{};
-		const Texture* m_pGloss{};
-		const Texture* m_pSpecular{};
+		Material m_Material{};
 
 		// Software
-		std::vector<Vertex_In> m_Vertices{};
-		std::vector<Vertex_Out> m_VerticesOut{};
-		std::vector<uint32_t> m_Indices{};
+		std::vector<MeshLod> m_Lods{ MeshLod{} };
 		PrimitiveTopology m_PrimitiveTopology{ PrimitiveTopology::TriangleList };
+		// Rate the software rasterizer shades every draw of the mesh at when variable rate shading is on
+		ShadingRate m_ShadingRate{ ShadingRate::Rate1x1 };
+
+		// Object space bounds of LOD 0, every LOD lies inside them
+		Vector3 m_BoundsMin{};
+		Vector3 m_BoundsMax{};
+		Vector3 m_BoundingSphereCenter{};
+		float m_BoundingSphereRadius{};
+
+		static constexpr int m_MaxLods{ 8 };
+		static constexpr size_t m_MinLodTriangles{ 64 };
 	};
 }
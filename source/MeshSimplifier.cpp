@@ -0,0 +1,368 @@
+#include "pch.h"
+#include "MeshSimplifier.h"
+
+#include <map>
+#include <unordered_map>
+
+namespace dae
+{
+	namespace
+	{
+		// Sum of the squared distances to a set of planes, weighted by the area they cover
+		struct Quadric
+		{
+			double a00{}, a01{}, a02{}, a03{};
+			double a11{}, a12{}, a13{};
+			double a22{}, a23{};
+			double a33{};
+			double weight{};
+
+			static Quadric FromPlane(const Vector3& normal, const Vector3& point, double weight)
+			{
+				const double a{ normal.x };
+				const double b{ normal.y };
+				const double c{ normal.z };
+				const double d{ -Vector3::Dot(normal, point) };
+
+				return
+				{
+					a * a * weight, a * b * weight, a * c * weight, a * d * weight,
+					b * b * weight, b * c * weight, b * d * weight,
+					c * c * weight, c * d * weight,
+					d * d * weight,
+					weight
+				};
+			}
+
+			Quadric operator+(const Quadric& q) const
+			{
+				return
+				{
+					a00 + q.a00, a01 + q.a01, a02 + q.a02, a03 + q.a03,
+					a11 + q.a11, a12 + q.a12, a13 + q.a13,
+					a22 + q.a22, a23 + q.a23,
+					a33 + q.a33,
+					weight + q.weight
+				};
+			}
+
+			Quadric& operator+=(const Quadric& q)
+			{
+				*this = *this + q;
+				return *this;
+			}
+
+			// Average squared distance of the point to the planes
+			double Error(const Vector3& point) const
+			{
+				if (weight <= 0.) return 0.;
+
+				const double x{ point.x };
+				const double y{ point.y };
+				const double z{ point.z };
+
+				const double error
+				{
+					a00 * x * x + a11 * y * y + a22 * z * z + a33 +
+					2. * (a01 * x * y + a02 * x * z + a12 * y * z + a03 * x + a13 * y + a23 * z)
+				};
+
+				return std::max(error, 0.) / weight;
+			}
+		};
+
+		enum class VertexKind : uint8_t
+		{
+			Manifold,
+			Border,
+			Locked
+		};
+
+		struct Collapse
+		{
+			uint32_t from{};
+			uint32_t to{};
+			double error{};
+		};
+
+		// Boundary edges are weighted heavily so open borders keep their shape
+		constexpr double BorderWeight{ 10. };
+
+		uint64_t EdgeKey(uint32_t a, uint32_t b)
+		{
+			return (static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b);
+		}
+	}
+
+	namespace MeshSimplifier
+	{
+		std::vector<uint32_t> Simplify(const std::vector<Vertex_In>& vertices, const std::vector<uint32_t>& indices, size_t targetIndexCount, float& error)
+		{
+			error = 0.f;
+
+			std::vector<uint32_t> result{ indices };
+			if (indices.size() <= targetIndexCount || vertices.empty()) return result;
+
+			const size_t vertexCount{ vertices.size() };
+			const size_t targetTriangleCount{ targetIndexCount / 3 };
+
+			// Vertices that share a position are collapsed as one, so attribute seams can not open up.
+			// remap points every vertex to the first vertex at its position, wedges lists the vertices at that position.
+			std::vector<uint32_t> remap(vertexCount);
+			std::vector<std::vector<uint32_t>> wedges(vertexCount);
+			{
+				std::map<std::tuple<float, float, float>, uint32_t> positions{};
+				for (uint32_t i{ 0 }; i < vertexCount; ++i)
+				{
+					const Vector3& pos{ vertices[i].pos };
+					const uint32_t first{ positions.try_emplace({ pos.x, pos.y, pos.z }, i).first->second };
+
+					remap[i] = first;
+					wedges[first].emplace_back(i);
+				}
+			}
+
+			const auto getPosition{ [&vertices](uint32_t vertex) -> const Vector3& { return vertices[vertex].pos; } };
+
+			std::unordered_map<uint64_t, uint32_t> edgeCounts{};
+			const auto countEdges{ [&]()
+				{
+					edgeCounts.clear();
+					for (size_t i{ 0 }; i < result.size(); i += 3)
+					{
+						for (int edge{ 0 }; edge < 3; ++edge)
+						{
+							++edgeCounts[EdgeKey(remap[result[i + edge]], remap[result[i + (edge + 1) % 3]])];
+						}
+					}
+				} };
+
+			// Plane quadrics of every triangle, plus a plane perpendicular to every border edge
+			std::vector<Quadric> quadrics(vertexCount);
+			countEdges();
+			for (size_t i{ 0 }; i < result.size(); i += 3)
+			{
+				const uint32_t corners[3]{ remap[result[i]], remap[result[i + 1]], remap[result[i + 2]] };
+
+				const Vector3 cross{ Vector3::Cross(getPosition(corners[1]) - getPosition(corners[0]), getPosition(corners[2]) - getPosition(corners[0])) };
+				const float length{ cross.Magnitude() };
+				if (length <= FLT_EPSILON) continue;
+
+				const Vector3 normal{ cross / length };
+				const Quadric plane{ Quadric::FromPlane(normal, getPosition(corners[0]), length * .5) };
+				for (const uint32_t corner : corners)
+				{
+					quadrics[corner] += plane;
+				}
+
+				for (int edge{ 0 }; edge < 3; ++edge)
+				{
+					const uint32_t a{ corners[edge] };
+					const uint32_t b{ corners[(edge + 1) % 3] };
+					if (edgeCounts[EdgeKey(a, b)] != 1) continue;
+
+					const Vector3 edgeVector{ getPosition(b) - getPosition(a) };
+					const Vector3 borderNormal{ Vector3::Cross(edgeVector, normal).Normalized() };
+					const Quadric border{ Quadric::FromPlane(borderNormal, getPosition(a), edgeVector.SqrMagnitude() * BorderWeight) };
+
+					quadrics[a] += border;
+					quadrics[b] += border;
+				}
+			}
+
+			std::vector<uint32_t> triangleOffsets(vertexCount + 1);
+			std::vector<uint32_t> vertexTriangles{};
+			std::vector<VertexKind> kinds(vertexCount);
+			std::vector<uint8_t> locked(vertexCount);
+			std::vector<uint32_t> collapseRemap(vertexCount);
+			std::vector<Collapse> collapses{};
+
+			double maxError{ 0. };
+
+			// Every pass collapses as many independent edges as it can, cheapest first
+			while (result.size() / 3 > targetTriangleCount)
+			{
+				const size_t triangleCount{ result.size() / 3 };
+
+				// Triangles around every vertex
+				std::ranges::fill(triangleOffsets, 0);
+				for (const uint32_t index : result)
+				{
+					++triangleOffsets[remap[index] + 1];
+				}
+				for (size_t i{ 0 }; i < vertexCount; ++i)
+				{
+					triangleOffsets[i + 1] += triangleOffsets[i];
+				}
+
+				vertexTriangles.resize(result.size());
+				{
+					std::vector<uint32_t> fill{ triangleOffsets.begin(), triangleOffsets.end() - 1 };
+					for (size_t i{ 0 }; i < result.size(); ++i)
+					{
+						vertexTriangles[fill[remap[result[i]]]++] = static_cast<uint32_t>(i / 3);
+					}
+				}
+
+				// Vertices on an open border may only slide along it, non-manifold vertices stay where they are
+				countEdges();
+				std::ranges::fill(kinds, VertexKind::Manifold);
+				for (const auto& [key, count] : edgeCounts)
+				{
+					const uint32_t a{ static_cast<uint32_t>(key >> 32) };
+					const uint32_t b{ static_cast<uint32_t>(key & 0xFFFFFFFF) };
+					const VertexKind kind{ count == 1 ? VertexKind::Border : count > 2 ? VertexKind::Locked : VertexKind::Manifold };
+
+					kinds[a] = std::max(kinds[a], kind);
+					kinds[b] = std::max(kinds[b], kind);
+				}
+
+				collapses.clear();
+				for (size_t i{ 0 }; i < result.size(); i += 3)
+				{
+					for (int edge{ 0 }; edge < 3; ++edge)
+					{
+						const uint32_t a{ remap[result[i + edge]] };
+						const uint32_t b{ remap[result[i + (edge + 1) % 3]] };
+						const bool isBorderEdge{ edgeCounts[EdgeKey(a, b)] == 1 };
+
+						for (const auto& [from, to] : { std::pair{ a, b }, std::pair{ b, a } })
+						{
+							if (kinds[from] == VertexKind::Locked) continue;
+							if (kinds[from] == VertexKind::Border && !isBorderEdge) continue;
+
+							collapses.emplace_back(Collapse{ from, to, (quadrics[from] + quadrics[to]).Error(getPosition(to)) });
+						}
+					}
+				}
+
+				std::ranges::sort(collapses, {}, &Collapse::error);
+				if (collapses.empty()) break;
+
+				// Every collapse removes about two triangles. Collapses that are much more expensive than the one
+				// that would reach the target are left for a later pass, where cheaper ones may have become available.
+				const size_t collapseGoal{ std::min((triangleCount - targetTriangleCount) / 2, collapses.size() - 1) };
+				const double errorLimit{ collapses[collapseGoal].error * 1.5 };
+
+				std::ranges::fill(locked, uint8_t{ 0 });
+				for (uint32_t i{ 0 }; i < vertexCount; ++i)
+				{
+					collapseRemap[i] = i;
+				}
+
+				size_t remainingTriangles{ triangleCount };
+				size_t nrCollapses{ 0 };
+
+				for (const Collapse& collapse : collapses)
+				{
+					if (remainingTriangles <= targetTriangleCount || collapse.error > errorLimit) break;
+					if (locked[collapse.from] || locked[collapse.to]) continue;
+
+					const uint32_t first{ triangleOffsets[collapse.from] };
+					const uint32_t last{ triangleOffsets[collapse.from + 1] };
+
+					// Reject collapses that fold triangles over
+					bool flips{ false };
+					size_t removedTriangles{ 0 };
+					for (uint32_t t{ first }; t < last && !flips; ++t)
+					{
+						const uint32_t triangle{ vertexTriangles[t] };
+						const uint32_t corners[3]{ remap[result[triangle * 3]], remap[result[triangle * 3 + 1]], remap[result[triangle * 3 + 2]] };
+
+						if (corners[0] == collapse.to || corners[1] == collapse.to || corners[2] == collapse.to)
+						{
+							++removedTriangles;
+							continue;
+						}
+
+						Vector3 positions[3]{ getPosition(corners[0]), getPosition(corners[1]), getPosition(corners[2]) };
+						const Vector3 oldNormal{ Vector3::Cross(positions[1] - positions[0], positions[2] - positions[0]) };
+
+						for (int corner{ 0 }; corner < 3; ++corner)
+						{
+							if (corners[corner] == collapse.from) positions[corner] = getPosition(collapse.to);
+						}
+						const Vector3 newNormal{ Vector3::Cross(positions[1] - positions[0], positions[2] - positions[0]) };
+
+						flips = Vector3::Dot(oldNormal, newNormal) < .25f * oldNormal.Magnitude() * newNormal.Magnitude();
+					}
+					if (flips) continue;
+
+					// Move every wedge onto the wedge it shares an edge with, or onto the one with the closest attributes
+					for (const uint32_t wedge : wedges[collapse.from])
+					{
+						uint32_t target{ UINT32_MAX };
+						for (uint32_t t{ first }; t < last && target == UINT32_MAX; ++t)
+						{
+							const uint32_t* pTriangle{ &result[vertexTriangles[t] * 3] };
+							if (pTriangle[0] != wedge && pTriangle[1] != wedge && pTriangle[2] != wedge) continue;
+
+							for (int corner{ 0 }; corner < 3; ++corner)
+							{
+								if (remap[pTriangle[corner]] == collapse.to) target = pTriangle[corner];
+							}
+						}
+
+						if (target == UINT32_MAX)
+						{
+							float closest{ FLT_MAX };
+							for (const uint32_t candidate : wedges[collapse.to])
+							{
+								const float distance
+								{
+									(vertices[candidate].uv - vertices[wedge].uv).SqrMagnitude() +
+									(vertices[candidate].norm - vertices[wedge].norm).SqrMagnitude()
+								};
+
+								if (distance < closest)
+								{
+									closest = distance;
+									target = candidate;
+								}
+							}
+						}
+
+						collapseRemap[wedge] = target;
+					}
+
+					quadrics[collapse.to] += quadrics[collapse.from];
+
+					// Lock the whole ring, the flip test of a later collapse would otherwise use stale positions
+					for (uint32_t t{ first }; t < last; ++t)
+					{
+						const uint32_t triangle{ vertexTriangles[t] };
+						for (int corner{ 0 }; corner < 3; ++corner)
+						{
+							locked[remap[result[triangle * 3 + corner]]] = 1;
+						}
+					}
+
+					maxError = std::max(maxError, collapse.error);
+					remainingTriangles -= removedTriangles;
+					++nrCollapses;
+				}
+
+				if (nrCollapses == 0) break;
+
+				// Apply the collapses and drop the triangles that became degenerate
+				size_t writeIndex{ 0 };
+				for (size_t i{ 0 }; i < result.size(); i += 3)
+				{
+					const uint32_t i0{ collapseRemap[result[i]] };
+					const uint32_t i1{ collapseRemap[result[i + 1]] };
+					const uint32_t i2{ collapseRemap[result[i + 2]] };
+
+					if (remap[i0] == remap[i1] || remap[i1] == remap[i2] || remap[i2] == remap[i0]) continue;
+
+					result[writeIndex++] = i0;
+					result[writeIndex++] = i1;
+					result[writeIndex++] = i2;
+				}
+				result.resize(writeIndex);
+			}
+
+			error = static_cast<float>(std::sqrt(maxError));
+			return result;
+		}
+	}
+}
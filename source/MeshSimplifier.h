@@ -0,0 +1,15 @@
+#pragma once
+#include "DataTypes.h"
+
+namespace dae
+{
+	// Quadric error metric simplifier that collapses vertices onto one of their neighbours.
+	// The vertex buffer is left untouched, only a smaller index buffer is produced.
+	namespace MeshSimplifier
+	{
+		// Simplifies a triangle list until it has at most targetIndexCount indices, or until no collapse is possible.
+		// error receives the square root of the largest quadric error of a collapse: the area weighted RMS distance, in object space,
+		// of the moved vertex to the planes of the triangles merged into it. An estimate of the deviation, not a bound on it.
+		std::vector<uint32_t> Simplify(const std::vector<Vertex_In>& vertices, const std::vector<uint32_t>& indices, size_t targetIndexCount, float& error);
+	}
+}
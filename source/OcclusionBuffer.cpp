@@ -0,0 +1,181 @@
+#include "pch.h"
+#include "OcclusionBuffer.h"
+
+#include <immintrin.h>
+
+namespace dae
+{
+	OcclusionBuffer::OcclusionBuffer()
+		: m_Depth(m_Width * m_Height)
+	{
+		static_assert(m_Width % 8 == 0, "Rows are rasterized eight pixels at a time");
+		Clear();
+	}
+
+	void OcclusionBuffer::Clear()
+	{
+		std::ranges::fill(m_Depth, FLT_MAX);
+	}
+
+	void OcclusionBuffer::RenderOccluder(const std::vector<Vertex_In>& vertices, const std::vector<uint32_t>& indices, PrimitiveTopology topology, const Matrix& worldViewProjMatrix)
+	{
+		m_ScreenVertices.resize(vertices.size());
+		for (size_t i{ 0 }; i < vertices.size(); ++i)
+		{
+			const Vector4 position{ worldViewProjMatrix.TransformPoint({ vertices[i].pos, 1.f }) };
+			if (position.w < m_MinW)
+			{
+				m_ScreenVertices[i] = { 0.f, 0.f, 0.f, -1.f };
+				continue;
+			}
+
+			const float inverseW{ 1.f / position.w };
+			m_ScreenVertices[i] =
+			{
+				(position.x * inverseW + 1.f) * .5f * m_Width,
+				(1.f - position.y * inverseW) * .5f * m_Height,
+				position.z * inverseW,
+				position.w
+			};
+		}
+
+		const bool isTriangleList{ topology == PrimitiveTopology::TriangleList };
+		const size_t increment{ isTriangleList ? 3u : 1u };
+		for (size_t i{ 0 }; i + 2 < indices.size(); i += increment)
+		{
+			const Vector4& v0{ m_ScreenVertices[indices[i]] };
+			const Vector4& v1{ m_ScreenVertices[indices[i + 1]] };
+			const Vector4& v2{ m_ScreenVertices[indices[i + 2]] };
+			if (v0.w < 0.f || v1.w < 0.f || v2.w < 0.f) continue;
+
+			RenderTriangle(v0, v1, v2);
+		}
+	}
+
+	void OcclusionBuffer::RenderTriangle(const Vector4& v0, const Vector4& v1, const Vector4& v2)
+	{
+		// Both windings are drawn, so the edge functions are flipped to be positive inside
+		const float area{ (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x) };
+		if (area == 0.f) return;
+
+		const Vector4& a{ v0 };
+		const Vector4& b{ area > 0.f ? v1 : v2 };
+		const Vector4& c{ area > 0.f ? v2 : v1 };
+
+		// Pixel centers inside the bounding box, the first column is aligned to a group of eight pixels
+		const int minX{ std::max(static_cast<int>(std::floor(std::min({ a.x, b.x, c.x }) - .5f)), 0) & ~7 };
+		const int maxX{ std::min(static_cast<int>(std::ceil(std::max({ a.x, b.x, c.x }) - .5f)), m_Width - 1) };
+		const int minY{ std::max(static_cast<int>(std::floor(std::min({ a.y, b.y, c.y }) - .5f)), 0) };
+		const int maxY{ std::min(static_cast<int>(std::ceil(std::max({ a.y, b.y, c.y }) - .5f)), m_Height - 1) };
+		if (minX > maxX || minY > maxY) return;
+
+		// Edge function of the edge from p to q at pixel (x, y): stepX * x + stepY * y + offset.
+		// The edges are moved inwards by half a pixel along both axes, so only pixels the triangle covers completely pass,
+		// anything just past the silhouette of an occluder stays visible.
+		struct Edge
+		{
+			float stepX;
+			float stepY;
+			float offset;
+		};
+		const auto createEdge{ [](const Vector4& p, const Vector4& q) -> Edge
+			{
+				const float stepX{ p.y - q.y };
+				const float stepY{ q.x - p.x };
+				return { stepX, stepY, (q.y - p.y) * p.x - (q.x - p.x) * p.y - .5f * (std::abs(stepX) + std::abs(stepY)) };
+			} };
+		const Edge edges[3]{ createEdge(a, b), createEdge(b, c), createEdge(c, a) };
+
+		const __m256 depth{ _mm256_set1_ps(std::max({ a.z, b.z, c.z })) };
+		const __m256 laneOffsets{ _mm256_setr_ps(.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f) };
+
+		__m256 stepX[3];
+		for (int i{ 0 }; i < 3; ++i)
+		{
+			stepX[i] = _mm256_set1_ps(edges[i].stepX);
+		}
+
+		for (int y{ minY }; y <= maxY; ++y)
+		{
+			const float centerY{ static_cast<float>(y) + .5f };
+			float* pRow{ m_Depth.data() + y * m_Width };
+
+			for (int x{ minX }; x <= maxX; x += 8)
+			{
+				const __m256 centerX{ _mm256_add_ps(_mm256_set1_ps(static_cast<float>(x)), laneOffsets) };
+
+				__m256 isInside{ _mm256_castsi256_ps(_mm256_set1_epi32(-1)) };
+				for (int i{ 0 }; i < 3; ++i)
+				{
+					const __m256 value{ _mm256_fmadd_ps(stepX[i], centerX, _mm256_set1_ps(edges[i].stepY * centerY + edges[i].offset)) };
+					isInside = _mm256_and_ps(isInside, _mm256_cmp_ps(value, _mm256_setzero_ps(), _CMP_GE_OQ));
+				}
+				if (_mm256_movemask_ps(isInside) == 0) continue;
+
+				const __m256 current{ _mm256_loadu_ps(pRow + x) };
+				_mm256_storeu_ps(pRow + x, _mm256_blendv_ps(current, _mm256_min_ps(current, depth), isInside));
+			}
+		}
+	}
+
+	bool OcclusionBuffer::IsBoxOccluded(const Bvh::Box& box, const Matrix& viewProjMatrix) const
+	{
+		float minX{ FLT_MAX };
+		float minY{ FLT_MAX };
+		float maxX{ -FLT_MAX };
+		float maxY{ -FLT_MAX };
+		float minDepth{ FLT_MAX };
+
+		for (int corner{ 0 }; corner < 8; ++corner)
+		{
+			const Vector3 position
+			{
+				corner & 1 ? box.max.x : box.min.x,
+				corner & 2 ? box.max.y : box.min.y,
+				corner & 4 ? box.max.z : box.min.z
+			};
+
+			// A box reaching behind the camera covers an unknown part of the screen, it is kept
+			const Vector4 projected{ viewProjMatrix.TransformPoint({ position, 1.f }) };
+			if (projected.w < m_MinW) return false;
+
+			const float inverseW{ 1.f / projected.w };
+			const float x{ (projected.x * inverseW + 1.f) * .5f * m_Width };
+			const float y{ (1.f - projected.y * inverseW) * .5f * m_Height };
+
+			minX = std::min(minX, x);
+			maxX = std::max(maxX, x);
+			minY = std::min(minY, y);
+			maxY = std::max(maxY, y);
+			minDepth = std::min(minDepth, projected.z * inverseW);
+		}
+
+		// Every pixel the rectangle touches, rounded outwards
+		const int firstX{ std::max(static_cast<int>(std::floor(minX)), 0) };
+		const int lastX{ std::min(static_cast<int>(std::ceil(maxX)), m_Width) };
+		const int firstY{ std::max(static_cast<int>(std::floor(minY)), 0) };
+		const int lastY{ std::min(static_cast<int>(std::ceil(maxY)), m_Height) };
+		if (firstX >= lastX || firstY >= lastY) return false;
+
+		const __m256 boxDepth{ _mm256_set1_ps(minDepth) };
+		for (int y{ firstY }; y < lastY; ++y)
+		{
+			const float* pRow{ m_Depth.data() + y * m_Width };
+
+			int x{ firstX };
+			for (; x + 8 <= lastX; x += 8)
+			{
+				// Any pixel at or behind the box leaves it potentially visible
+				const __m256 isVisible{ _mm256_cmp_ps(_mm256_loadu_ps(pRow + x), boxDepth, _CMP_GE_OQ) };
+				if (_mm256_movemask_ps(isVisible) != 0) return false;
+			}
+
+			for (; x < lastX; ++x)
+			{
+				if (pRow[x] >= minDepth) return false;
+			}
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include "Bvh.h"
+#include "DataTypes.h"
+
+namespace dae
+{
+	// Low resolution depth only buffer for software occlusion culling.
+	// A few large occluders are rasterized into it, after which the screen space bounds of every mesh are tested against it.
+	class OcclusionBuffer final
+	{
+	public:
+		static constexpr int m_Width{ 256 };
+		static constexpr int m_Height{ 128 };
+
+		OcclusionBuffer();
+		~OcclusionBuffer() = default;
+
+		OcclusionBuffer(const OcclusionBuffer&) = delete;
+		OcclusionBuffer(OcclusionBuffer&&) noexcept = delete;
+		OcclusionBuffer& operator=(const OcclusionBuffer&) = delete;
+		OcclusionBuffer& operator=(OcclusionBuffer&&) noexcept = delete;
+
+		void Clear();
+
+		// Rasterizes the triangles eight pixels at a time. Every triangle writes the depth of its farthest vertex,
+		// so the buffer never holds a depth nearer than the occluder really is. Only pixels an occluder covers completely are written.
+		void RenderOccluder(const std::vector<Vertex_In>& vertices, const std::vector<uint32_t>& indices, PrimitiveTopology topology, const Matrix& worldViewProjMatrix);
+
+		// True when every pixel under the screen space rectangle of the box holds an occluder nearer than the nearest corner of the box
+		bool IsBoxOccluded(const Bvh::Box& box, const Matrix& viewProjMatrix) const;
+
+	private:
+		std::vector<float> m_Depth{};
+
+		// Transformed occluder vertices in buffer pixels, w < 0 marks vertices in front of the near plane
+		std::vector<Vector4> m_ScreenVertices{};
+
+		// Triangles crossing the near plane are skipped, clipping them is not worth it for culling
+		static constexpr float m_MinW{ 1e-4f };
+
+		void RenderTriangle(const Vector4& v0, const Vector4& v1, const Vector4& v2);
+	};
+}
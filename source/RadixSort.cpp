@@ -0,0 +1,45 @@
+#include "pch.h"
+#include "RadixSort.h"
+
+namespace dae
+{
+	void RadixSort::Sort(std::vector<Entry>& entries)
+	{
+		if (entries.size() < 2) return;
+
+		// Count both digits in a single pass over the keys
+		uint32_t counts[2][m_NrBuckets]{};
+		for (const Entry& entry : entries)
+		{
+			++counts[0][entry.key & 0xFF];
+			++counts[1][entry.key >> 8];
+		}
+
+		m_Scratch.resize(entries.size());
+		std::vector<Entry>* pSource{ &entries };
+		std::vector<Entry>* pDestination{ &m_Scratch };
+
+		for (int digit{ 0 }; digit < 2; ++digit)
+		{
+			// All keys share this digit, the pass would only copy
+			if (counts[digit][(entries.front().key >> (digit * 8)) & 0xFF] == entries.size()) continue;
+
+			// Turn the counts into the first output position of every bucket
+			uint32_t offset{ 0 };
+			for (uint32_t& count : counts[digit])
+			{
+				const uint32_t bucketSize{ count };
+				count = offset;
+				offset += bucketSize;
+			}
+
+			for (const Entry& entry : *pSource)
+			{
+				(*pDestination)[counts[digit][(entry.key >> (digit * 8)) & 0xFF]++] = entry;
+			}
+			std::swap(pSource, pDestination);
+		}
+
+		if (pSource != &entries) entries.swap(m_Scratch);
+	}
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+namespace dae
+{
+	// Stable least significant digit radix sort of (key, value) pairs on 16 bit keys.
+	// Two passes over 256 buckets, linear in the number of entries. The scratch buffer is kept between sorts,
+	// so sorting every frame does not allocate once it has grown.
+	class RadixSort final
+	{
+	public:
+		struct Entry
+		{
+			uint16_t key{};
+			uint32_t value{};
+		};
+
+		RadixSort() = default;
+		~RadixSort() = default;
+
+		RadixSort(const RadixSort&) = delete;
+		RadixSort(RadixSort&&) noexcept = delete;
+		RadixSort& operator=(const RadixSort&) = delete;
+		RadixSort& operator=(RadixSort&&) noexcept = delete;
+
+		// Sorts ascending by key, entries with equal keys keep their order
+		void Sort(std::vector<Entry>& entries);
+
+	private:
+		std::vector<Entry> m_Scratch{};
+
+		static constexpr int m_NrBuckets{ 256 };
+	};
+}
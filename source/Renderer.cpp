@@ -1,28 +1,31 @@
 #include "pch.h"
 #include "Renderer.h"
 
+#include "AssetLoader.h"
 #include "Camera.h"
 #include "EffectFire.h"
 #include "EffectPhong.h"
 #include "Mesh.h"
+#include "SceneFile.h"
+#include "StreamingMesh.h"
 #include "Texture.h"
-#include "Utils.h"
 
 #include "HardwareRasterizer.h"
 #include "SoftwareRasterizer.h"
 
 namespace dae {
-	Renderer::Renderer(SDL_Window* pWindow) :
+	Renderer::Renderer(SDL_Window* pWindow, const std::string& scenePath) :
 		m_pWindow{ pWindow },
 		m_pCamera{ new Camera{} },
 		m_pHardwareRasterizer{ new HardwareRasterizer{ pWindow } },
-		m_pSoftwareRasterizer{ new SoftwareRasterizer{ pWindow } }
+		m_pSoftwareRasterizer{ new SoftwareRasterizer{ pWindow } },
+		m_pAssetLoader{ new AssetLoader{} }
 	{
 		//Initialize
 		SDL_GetWindowSize(pWindow, &m_Width, &m_Height);
 
 		InitCamera();
-		InitVehicle({ .0f, .0f, 50.f });
+		LoadScene(scenePath);
 
 		PrintKeybinds();
 
@@ -31,6 +34,38 @@ namespace dae {
 
 	Renderer::~Renderer()
 	{
+		// Destroy the asset loader first, this waits for the loads that are still running
+		delete m_pAssetLoader;
+		m_pAssetLoader = nullptr;
+
+		// Clean up assets that finished loading but were never picked up
+		for (PendingMesh& pendingMesh : m_PendingMeshes)
+		{
+			delete pendingMesh.mesh.get();
+		}
+		m_PendingMeshes.clear();
+
+		for (const std::shared_future<Texture*>& pendingTexture : m_PendingTextures)
+		{
+			delete pendingTexture.get();
+		}
+		m_PendingTextures.clear();
+		m_PendingTextureBindings.clear();
+
+		for (auto& [pendingMesh, position] : m_PendingStreamingMeshes)
+		{
+			delete pendingMesh.get();
+		}
+		m_PendingStreamingMeshes.clear();
+
+		for (PendingModel& pendingModel : m_PendingModels)
+		{
+			const LoadedModel model{ pendingModel.model.get() };
+			for (const Mesh* pMesh : model.meshes) delete pMesh;
+			for (const Texture* pTexture : model.textures) delete pTexture;
+		}
+		m_PendingModels.clear();
+
 		// Destroy the hardware rasterizer
 		delete m_pHardwareRasterizer;
 		m_pHardwareRasterizer = nullptr;
@@ -47,6 +82,13 @@ namespace dae {
 		}
 		m_pMeshes.clear();
 
+		for (StreamingMesh* pStreamingMesh : m_pStreamingMeshes)
+		{
+			delete pStreamingMesh;
+			pStreamingMesh = nullptr;
+		}
+		m_pStreamingMeshes.clear();
+
 		// Clean up textures
 		for (const Texture* pTexture : m_pTextures)
 		{
@@ -62,6 +104,8 @@ namespace dae {
 
 	void Renderer::Update(const Timer* pTimer)
 	{
+		UpdatePendingAssets();
+
 		m_pCamera->Update(pTimer);
 
 		for (Mesh* pMesh : m_pMeshes)
@@ -69,6 +113,15 @@ namespace dae {
 			if (m_RotateMesh) pMesh->RotateY(m_RotationSpeed * pTimer->GetElapsed());
 			pMesh->SetMatrices(m_pCamera->GetViewMatrix() * m_pCamera->GetProjectionMatrix(), m_pCamera->GetInvViewMatrix());
 		}
+
+		for (StreamingMesh* pStreamingMesh : m_pStreamingMeshes)
+		{
+			if (m_RotateMesh) pStreamingMesh->RotateY(m_RotationSpeed * pTimer->GetElapsed());
+
+			// Residency only matters for the software rasterizer, the hardware path does not draw streaming meshes.
+			// They keep rotating in hardware mode, so they are in step with the other meshes when switching back.
+			if (m_RasterizerMode == RasterizerMode::Software) pStreamingMesh->UpdateResidency(m_pCamera->GetViewMatrix() * m_pCamera->GetProjectionMatrix(), m_pCamera->GetPosition());
+		}
 	}
 
 	void Renderer::Render() const
@@ -91,9 +144,14 @@ namespace dae {
 
 	bool Renderer::ToggleFireFxMesh()
 	{
-		if (m_RasterizerMode != RasterizerMode::Hardware) return false;
+		if (m_RasterizerMode != RasterizerMode::Hardware || m_pFireFxMeshes.empty()) return false;
 
-		return m_pMeshes.back()->ToggleVisibility();
+		bool isVisible{};
+		for (Mesh* pFireFxMesh : m_pFireFxMeshes)
+		{
+			isVisible = pFireFxMesh->ToggleVisibility();
+		}
+		return isVisible;
 	}
 
 	bool Renderer::ToggleBoundingBox()
@@ -111,6 +169,31 @@ namespace dae {
 		return m_pSoftwareRasterizer->ToggleNormalMap();
 	}
 
+	bool Renderer::ToggleCompactVertices()
+	{
+		return m_pSoftwareRasterizer->ToggleCompactVertices();
+	}
+
+	bool Renderer::ToggleLods()
+	{
+		return m_pSoftwareRasterizer->ToggleLods();
+	}
+
+	bool Renderer::ToggleOcclusionCulling()
+	{
+		return m_pSoftwareRasterizer->ToggleOcclusionCulling();
+	}
+
+	bool Renderer::ToggleEdgeAntiAliasing()
+	{
+		return m_pSoftwareRasterizer->ToggleEdgeAntiAliasing();
+	}
+
+	bool Renderer::ToggleCoverageBuffer()
+	{
+		return m_pSoftwareRasterizer->ToggleCoverageBuffer();
+	}
+
 	void Renderer::CycleCullMode()
 	{
 		static constexpr int enumSize{ sizeof(CullMode) - 1 };
@@ -141,7 +224,7 @@ namespace dae {
 	void Renderer::CycleTechniques() const
 	{
 		// Check if not in software mode
-		if (m_RasterizerMode == RasterizerMode::Software) return;
+		if (m_RasterizerMode == RasterizerMode::Software || m_pMeshes.empty()) return;
 
 		std::string techniqueName{};
 		for (const auto& pMesh : m_pMeshes)
@@ -163,68 +246,206 @@ namespace dae {
 		m_pSoftwareRasterizer->CycleShadingMode();
 	}
 
-	void Renderer::InitCamera()
+	void Renderer::CycleSampleCount()
 	{
-		m_pCamera->Initialize(static_cast<float>(m_Width) / static_cast<float>(m_Height), 45.f);
+		if (m_RasterizerMode != RasterizerMode::Software) return;
+
+		m_pSoftwareRasterizer->CycleSampleCount();
 	}
 
-	void Renderer::InitVehicle(const Vector3& position)
+	void Renderer::CycleDepthFormat()
 	{
-		// Initialize vehicle
-		std::vector<Vertex_In> vertices;
-		std::vector<uint32_t> indices;
-		Utils::ParseOBJ("Resources/vehicle.obj", vertices, indices);
+		if (m_RasterizerMode != RasterizerMode::Software) return;
+
+		m_pSoftwareRasterizer->CycleDepthFormat();
+	}
+
+	void Renderer::CycleShadingRateMode()
+	{
+		if (m_RasterizerMode != RasterizerMode::Software) return;
+
+		m_pSoftwareRasterizer->CycleShadingRateMode();
+	}
+
+	bool Renderer::LoadScene(const std::string& scenePath)
+	{
+		SceneFile scene{};
+		if (!scene.Load(scenePath)) return false;
 
-		ID3D11DeviceContext* pDeviceContext{ m_pHardwareRasterizer->GetDeviceContext() };
 		ID3D11Device* pDevice{ m_pHardwareRasterizer->GetDevice() };
 
-		EffectPhong* pVehicleEffect{ new EffectPhong{ pDevice, L"Resources/PosCol3D.fx" } };
-		m_pMeshes.emplace_back(new Mesh{ pDevice, pVehicleEffect, vertices, indices });
-		m_pMeshes.front()->SetIndices(indices);
-		m_pMeshes.front()->SetPosition(position);
-		m_pMeshes.front()->SetVertices(vertices);
-
-		// Set vehicle diffuse
-		m_pTextures.emplace_back(Texture::LoadFromFile(pDevice, "Resources/vehicle_diffuse.png"));
-		pDeviceContext->GenerateMips(m_pTextures.back()->GetSRV());
-		m_pMeshes.front()->SetDiffuse(m_pTextures.back());
-
-		// Set vehicle normal
-		m_pTextures.emplace_back(Texture::LoadFromFile(pDevice, "Resources/vehicle_normal.png"));
-		pDeviceContext->GenerateMips(m_pTextures.back()->GetSRV());
-		m_pMeshes.front()->SetNormal(m_pTextures.back());
-
-		// Set vehicle gloss
-		m_pTextures.emplace_back(Texture::LoadFromFile(pDevice, "Resources/vehicle_gloss.png"));
-		pDeviceContext->GenerateMips(m_pTextures.back()->GetSRV());
-		m_pMeshes.front()->SetGloss(m_pTextures.back());
-
-		// Set vehicle specular
-		m_pTextures.emplace_back(Texture::LoadFromFile(pDevice, "Resources/vehicle_specular.png"));
-		pDeviceContext->GenerateMips(m_pTextures.back()->GetSRV());
-		m_pMeshes.front()->SetSpecular(m_pTextures.back());
-
-		// Initialize fire effect
-		vertices.clear();
-		indices.clear();
-		Utils::ParseOBJ("Resources/fireFX.obj", vertices, indices);
-
-		EffectFire* pFireEffect{ new EffectFire{ pDevice, L"Resources/FireEffect3D.fx" } };
-		m_pMeshes.emplace_back(new Mesh{ pDevice, pFireEffect, vertices, indices });
-		m_pMeshes.back()->SetIndices(indices);
-		m_pMeshes.back()->SetPosition(position);
-		m_pMeshes.back()->SetVertices(vertices);
-
-		// Set FireFX diffuse
-		m_pTextures.emplace_back(Texture::LoadFromFile(pDevice, "Resources/fireFX_diffuse.png"));
-		pDeviceContext->GenerateMips(m_pTextures.back()->GetSRV());
-		m_pMeshes.back()->SetDiffuse(m_pTextures.back());
-		m_pMeshes.back()->SetPosition(position);
-
-		// All meshes
-		//m_pSoftwareRasterizer->SetMeshes(m_pMeshes);
-		// Only set the vehicle mesh
-		m_pSoftwareRasterizer->SetMeshes({ m_pMeshes.front() });
+		// Textures shared by several materials are only loaded once
+		std::vector<std::pair<std::string, std::shared_future<Texture*>>> textures{};
+		const auto bindTexture{ [&](const std::string& path, const std::shared_future<Mesh*>& mesh, void (Mesh::* setter)(const Texture*))
+			{
+				if (path.empty()) return;
+
+				auto it{ std::ranges::find(textures, path, &std::pair<std::string, std::shared_future<Texture*>>::first) };
+				if (it == textures.end())
+				{
+					const std::shared_future<Texture*> texture{ m_pAssetLoader->LoadTextureAsync(pDevice, path) };
+					m_PendingTextures.emplace_back(texture);
+					it = textures.emplace(textures.end(), path, texture);
+				}
+
+				m_PendingTextureBindings.emplace_back(it->second, mesh, setter);
+			} };
+
+		for (const SceneFile::MeshEntry& entry : scene.GetMeshes())
+		{
+			// A mesh without instances is never drawn, so it is not loaded either
+			if (entry.instances.empty()) continue;
+
+			if (entry.path.ends_with(".glb"))
+			{
+				m_PendingModels.emplace_back(m_pAssetLoader->LoadModelAsync<EffectPhong>(pDevice, entry.path, L"Resources/PosCol3D.fx"), entry.instances, entry.shadingRate);
+				continue;
+			}
+
+			const bool isFireFx{ entry.effect == SceneFile::EffectType::Fire };
+			const std::shared_future<Mesh*> mesh
+			{
+				isFireFx ?
+				m_pAssetLoader->LoadMeshAsync<EffectFire>(pDevice, entry.path, L"Resources/FireEffect3D.fx") :
+				m_pAssetLoader->LoadMeshAsync<EffectPhong>(pDevice, entry.path, L"Resources/PosCol3D.fx")
+			};
+
+			m_PendingMeshes.emplace_back(mesh, [this, instances = entry.instances, isFireFx, isSoftware = entry.software, shadingRate = entry.shadingRate](Mesh* pMesh)
+				{
+					pMesh->SetInstances(instances);
+					pMesh->SetShadingRate(shadingRate);
+
+					if (isFireFx) m_pFireFxMeshes.emplace_back(pMesh);
+					if (!isSoftware) return;
+
+					m_pSoftwareMeshes.emplace_back(pMesh);
+					m_pSoftwareRasterizer->SetMeshes(m_pSoftwareMeshes);
+				});
+
+			if (const SceneFile::MaterialEntry* pMaterial{ scene.FindMaterial(entry.material) })
+			{
+				bindTexture(pMaterial->diffuse, mesh, &Mesh::SetDiffuse);
+				bindTexture(pMaterial->normal, mesh, &Mesh::SetNormal);
+				bindTexture(pMaterial->gloss, mesh, &Mesh::SetGloss);
+				bindTexture(pMaterial->specular, mesh, &Mesh::SetSpecular);
+			}
+		}
+
+		return true;
+	}
+
+	void Renderer::PickInstance(int x, int y) const
+	{
+		SetConsoleTextAttribute(GetStdHandle(STD_OUTPUT_HANDLE), 6);
+
+		SoftwareRasterizer::InstancePick pick{};
+		if (!m_pSoftwareRasterizer->PickInstance(x, y, pick))
+		{
+			std::cout << "**(SHARED) Picked NOTHING\n";
+			return;
+		}
+
+		const auto meshIndex{ std::ranges::find(m_pSoftwareMeshes, pick.pMesh) - m_pSoftwareMeshes.begin() };
+		std::cout << "**(SHARED) Picked MESH " << meshIndex << " INSTANCE " << pick.instance << " at distance " << pick.distance << '\n';
+	}
+
+	void Renderer::AddModel(const std::string& glbPath, const Vector3& position)
+	{
+		m_PendingModels.emplace_back(m_pAssetLoader->LoadModelAsync<EffectPhong>(m_pHardwareRasterizer->GetDevice(), glbPath, L"Resources/PosCol3D.fx"), std::vector<Matrix>{ Matrix::CreateTranslation(position) });
+	}
+
+	void Renderer::AddStreamingMesh(const std::string& objPath, size_t memoryBudget, const Vector3& position)
+	{
+		m_PendingStreamingMeshes.emplace_back(m_pAssetLoader->LoadStreamingMeshAsync(objPath, memoryBudget), position);
+	}
+
+	void Renderer::InitCamera()
+	{
+		m_pCamera->Initialize(static_cast<float>(m_Width) / static_cast<float>(m_Height), 45.f);
+	}
+
+	void Renderer::UpdatePendingAssets()
+	{
+		// Meshes are picked up in the order they were queued, so m_pMeshes keeps the same order whichever load finishes first
+		size_t nrReadyMeshes{ 0 };
+		for (PendingMesh& pendingMesh : m_PendingMeshes)
+		{
+			if (!AssetLoader::IsReady(pendingMesh.mesh)) break;
+
+			if (Mesh* pMesh{ pendingMesh.mesh.get() })
+			{
+				m_pMeshes.emplace_back(pMesh);
+				pendingMesh.onReady(pMesh);
+			}
+			++nrReadyMeshes;
+		}
+		m_PendingMeshes.erase(m_PendingMeshes.begin(), m_PendingMeshes.begin() + nrReadyMeshes);
+
+		// Textures are swapped in as soon as both the texture and the mesh using it are resident
+		std::erase_if(m_PendingTextureBindings, [](const PendingTextureBinding& binding)
+			{
+				if (!AssetLoader::IsReady(binding.texture) || !AssetLoader::IsReady(binding.mesh)) return false;
+
+				const Texture* pTexture{ binding.texture.get() };
+				Mesh* pMesh{ binding.mesh.get() };
+				if (pTexture && pMesh)
+				{
+					(pMesh->*binding.setter)(pTexture);
+				}
+				return true;
+			});
+
+		std::erase_if(m_PendingTextures, [this](const std::shared_future<Texture*>& pendingTexture)
+			{
+				if (!AssetLoader::IsReady(pendingTexture)) return false;
+
+				if (const Texture* pTexture{ pendingTexture.get() })
+				{
+					m_pTextures.emplace_back(pTexture);
+				}
+				return true;
+			});
+
+		const size_t nrSoftwareMeshes{ m_pSoftwareMeshes.size() };
+		std::erase_if(m_PendingModels, [this](PendingModel& pendingModel)
+			{
+				if (!AssetLoader::IsReady(pendingModel.model)) return false;
+
+				LoadedModel loadedModel{ pendingModel.model.get() };
+				for (Mesh* pMesh : loadedModel.meshes)
+				{
+					pMesh->SetInstances(pendingModel.instances);
+					pMesh->SetShadingRate(pendingModel.shadingRate);
+					m_pMeshes.emplace_back(pMesh);
+					m_pSoftwareMeshes.emplace_back(pMesh);
+				}
+				m_pTextures.insert(m_pTextures.end(), loadedModel.textures.begin(), loadedModel.textures.end());
+				return true;
+			});
+
+		if (m_pSoftwareMeshes.size() != nrSoftwareMeshes)
+		{
+			m_pSoftwareRasterizer->SetMeshes(m_pSoftwareMeshes);
+		}
+
+		const size_t nrStreamingMeshes{ m_pStreamingMeshes.size() };
+		std::erase_if(m_PendingStreamingMeshes, [this](auto& pendingStreamingMesh)
+			{
+				auto& [pendingMesh, position] { pendingStreamingMesh };
+				if (!AssetLoader::IsReady(pendingMesh)) return false;
+
+				if (StreamingMesh* pStreamingMesh{ pendingMesh.get() })
+				{
+					pStreamingMesh->SetPosition(position);
+					m_pStreamingMeshes.emplace_back(pStreamingMesh);
+				}
+				return true;
+			});
+
+		if (m_pStreamingMeshes.size() != nrStreamingMeshes)
+		{
+			m_pSoftwareRasterizer->SetStreamingMeshes(m_pStreamingMeshes);
+		}
 	}
 
 	void Renderer::PrintKeybinds() const
@@ -237,7 +458,8 @@ namespace dae {
 			<< "   [F2]  Toggle Vehicle Rotation (ON/OFF)\n"
 			<< "   [F9]  Cycle CullMode (BACK/FRONT/NONE)\n"
 			<< "   [F10] Toggle Uniform ClearColor (ON/OFF)\n"
-			<< "   [F11] Toggle Print FPS (ON/OFF)\n\n";
+			<< "   [F11] Toggle Print FPS (ON/OFF)\n"
+			<< "   [3]   Pick Instance Under Cursor\n\n";
 
 		// Print HARDWARE keybinds
 		// Change console text color to green
@@ -253,6 +475,14 @@ namespace dae {
 			<< "   [F5] Cycle Shading Mode (COMBINED/OBSERVED_AREA/DIFFUSE/SPECULAR)\n"
 			<< "   [F6] Toggle NormalMap (ON/OFF)\n"
 			<< "   [F7] Toggle DepthBuffer Visualization (ON/OFF)\n"
-			<< "   [F8] Toggle BoundingBox Visualization (ON/OFF)\n\n\n";
+			<< "   [F8] Toggle BoundingBox Visualization (ON/OFF)\n"
+			<< "   [1]  Toggle Compact Vertices (ON/OFF)\n"
+			<< "   [2]  Toggle LOD Selection (ON/OFF)\n"
+			<< "   [4]  Toggle Occlusion Culling (ON/OFF)\n"
+			<< "   [5]  Cycle MSAA (1X/2X/4X/8X)\n"
+			<< "   [6]  Toggle Edge Anti-Aliasing (ON/OFF)\n"
+			<< "   [7]  Cycle Depth Format (FLOAT/REVERSED_FLOAT/UNORM24/UNORM16)\n"
+			<< "   [8]  Toggle Coverage Buffer (ON/OFF)\n"
+			<< "   [9]  Cycle Variable Rate Shading (OFF/PER_DRAW/CONTRAST)\n\n\n";
 	}
 }
@@ -1,4 +1,6 @@
 #pragma once
+#include <functional>
+#include <future>
 
 #include "DataTypes.h"
 
@@ -7,9 +9,11 @@ struct SDL_Surface;
 
 namespace dae
 {
+	class AssetLoader;
 	class HardwareRasterizer;
 	class SoftwareRasterizer;
 	class Mesh;
+	class StreamingMesh;
 	class Texture;
 
 	struct Camera;
@@ -17,7 +21,7 @@ namespace dae
 	class Renderer final
 	{
 	public:
-		explicit Renderer(SDL_Window* pWindow);
+		explicit Renderer(SDL_Window* pWindow, const std::string& scenePath = "Resources/vehicle_scene.json");
 		~Renderer();
 
 		Renderer(const Renderer&) = delete;
@@ -38,9 +42,26 @@ namespace dae
 		bool ToggleSoftwareRasterizer() { m_RasterizerMode = m_RasterizerMode == RasterizerMode::Hardware ? RasterizerMode::Software : RasterizerMode::Hardware; return m_RasterizerMode == RasterizerMode::Software; }
 		bool ToggleUniformClearColor() { m_UniformClearColor = !m_UniformClearColor; return m_UniformClearColor; }
 		bool ToggleNormalMap();
+		bool ToggleCompactVertices();
+		bool ToggleLods();
+		bool ToggleOcclusionCulling();
+		bool ToggleEdgeAntiAliasing();
+		bool ToggleCoverageBuffer();
 		void CycleCullMode();
 		void CycleTechniques() const;
 		void CycleShadingMode();
+		void CycleSampleCount();
+		void CycleDepthFormat();
+		void CycleShadingRateMode();
+		// Prints the mesh instance under a pixel of the window
+		void PickInstance(int x, int y) const;
+
+		// Loads the meshes, materials and instances of a scene file, see SceneFile for the format
+		bool LoadScene(const std::string& scenePath);
+		// Loads every mesh of a .glb file, rendered by both rasterizers
+		void AddModel(const std::string& glbPath, const Vector3& position = Vector3{ 0.f, 0.f, 0.f });
+		// Streams a mesh that is too large to keep in memory, only rendered by the software rasterizer
+		void AddStreamingMesh(const std::string& objPath, size_t memoryBudget, const Vector3& position = Vector3{ 0.f, 0.f, 0.f });
 
 	private:
 		CullMode m_CullMode{ CullMode::Back };
@@ -64,7 +85,9 @@ namespace dae
 
 		Camera* m_pCamera{ nullptr };
 		std::vector<Mesh*> m_pMeshes{};
+		std::vector<Mesh*> m_pSoftwareMeshes{};
 		std::vector<const Texture*> m_pTextures{};
+		std::vector<StreamingMesh*> m_pStreamingMeshes{};
 
 		const ColorRGB m_HardwareColor{ .39f, .59f, .93f };
 		const ColorRGB m_SoftwareColor{ .39f, .39f, .39f };
@@ -74,8 +97,39 @@ namespace dae
 		HardwareRasterizer* m_pHardwareRasterizer{ nullptr };
 		SoftwareRasterizer* m_pSoftwareRasterizer{ nullptr };
 
+		// Assets that are still loading on the worker threads, picked up in Update once they are ready
+		struct PendingMesh
+		{
+			std::shared_future<Mesh*> mesh;
+			std::function<void(Mesh*)> onReady;
+		};
+
+		// A texture can be bound to several meshes, it is owned by m_PendingTextures until it is moved to m_pTextures
+		struct PendingTextureBinding
+		{
+			std::shared_future<Texture*> texture;
+			std::shared_future<Mesh*> mesh;
+			void (Mesh::* setter)(const Texture*);
+		};
+
+		struct PendingModel
+		{
+			std::future<LoadedModel> model;
+			std::vector<Matrix> instances;
+			ShadingRate shadingRate{ ShadingRate::Rate1x1 };
+		};
+
+		AssetLoader* m_pAssetLoader{ nullptr };
+		std::vector<PendingMesh> m_PendingMeshes{};
+		std::vector<std::shared_future<Texture*>> m_PendingTextures{};
+		std::vector<PendingTextureBinding> m_PendingTextureBindings{};
+		std::vector<std::pair<std::future<StreamingMesh*>, Vector3>> m_PendingStreamingMeshes{};
+		std::vector<PendingModel> m_PendingModels{};
+
+		std::vector<Mesh*> m_pFireFxMeshes{};
+
 		void InitCamera();
-		void InitVehicle(const Vector3& position = Vector3{ 0.f, 0.f, 0.f });
+		void UpdatePendingAssets();
 
 		void PrintKeybinds() const;
 	};
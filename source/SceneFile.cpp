@@ -0,0 +1,198 @@
+#include "pch.h"
+#include "SceneFile.h"
+
+#include <fstream>
+
+#include "Json.h"
+
+namespace dae
+{
+	bool SceneFile::Load(const std::string& path)
+	{
+		m_Path = path;
+		m_Materials.clear();
+		m_Meshes.clear();
+
+		std::ifstream file{ path, std::ios::binary };
+		if (!file)
+		{
+			std::cout << "SceneFile: failed to open " << path << '\n';
+			return false;
+		}
+
+		std::stringstream text{};
+		text << file.rdbuf();
+
+		JsonValue document{};
+		if (!JsonValue::Parse(text.str(), document) || !document.IsObject())
+		{
+			std::cout << "SceneFile: " << path << " is not a valid scene\n";
+			return false;
+		}
+
+		if (!ReadMaterials(document["materials"]) || !ReadMeshes(document["meshes"])) return false;
+
+		const JsonValue& instances{ document["instances"] };
+		for (size_t i{ 0 }; i < instances.GetSize(); ++i)
+		{
+			if (!ReadInstance(instances[i])) return false;
+		}
+
+		return true;
+	}
+
+	const SceneFile::MaterialEntry* SceneFile::FindMaterial(const std::string& name) const
+	{
+		const auto it{ std::ranges::find(m_Materials, name, &MaterialEntry::name) };
+		return it != m_Materials.end() ? &*it : nullptr;
+	}
+
+	SceneFile::MeshEntry* SceneFile::FindMesh(const std::string& name)
+	{
+		const auto it{ std::ranges::find(m_Meshes, name, &MeshEntry::name) };
+		return it != m_Meshes.end() ? &*it : nullptr;
+	}
+
+	bool SceneFile::ReadMaterials(const JsonValue& materials)
+	{
+		// "materials": { "<name>": { "diffuse": "<path>", "normal": "<path>", "gloss": "<path>", "specular": "<path>" } }
+		for (size_t i{ 0 }; i < materials.GetKeys().size(); ++i)
+		{
+			const JsonValue& material{ materials.GetValues()[i] };
+
+			MaterialEntry entry{};
+			entry.name = materials.GetKeys()[i];
+			entry.diffuse = material["diffuse"].AsString();
+			entry.normal = material["normal"].AsString();
+			entry.gloss = material["gloss"].AsString();
+			entry.specular = material["specular"].AsString();
+
+			m_Materials.emplace_back(std::move(entry));
+		}
+
+		return true;
+	}
+
+	bool SceneFile::ReadMeshes(const JsonValue& meshes)
+	{
+		// "meshes": { "<name>": { "path": "<.obj or .glb>", "material": "<name>", "effect": "phong" | "fire",
+		//   "shadingRate": "1x1" | "2x1" | "1x2" | "2x2" } }
+		for (size_t i{ 0 }; i < meshes.GetKeys().size(); ++i)
+		{
+			const JsonValue& mesh{ meshes.GetValues()[i] };
+
+			MeshEntry entry{};
+			entry.name = meshes.GetKeys()[i];
+			entry.path = mesh["path"].AsString();
+			entry.material = mesh["material"].AsString();
+
+			if (entry.path.empty())
+			{
+				std::cout << "SceneFile: mesh \"" << entry.name << "\" has no path in " << m_Path << '\n';
+				return false;
+			}
+
+			if (!entry.material.empty() && !FindMaterial(entry.material))
+			{
+				std::cout << "SceneFile: mesh \"" << entry.name << "\" uses unknown material \"" << entry.material << "\" in " << m_Path << '\n';
+				return false;
+			}
+
+			const std::string& effect{ mesh["effect"].AsString() };
+			if (effect == "fire")
+			{
+				entry.effect = EffectType::Fire;
+			}
+			else if (!effect.empty() && effect != "phong")
+			{
+				std::cout << "SceneFile: mesh \"" << entry.name << "\" uses unknown effect \"" << effect << "\" in " << m_Path << '\n';
+				return false;
+			}
+
+			entry.software = mesh["software"].AsBool(entry.effect != EffectType::Fire);
+
+			const std::string& shadingRate{ mesh["shadingRate"].AsString() };
+			if (shadingRate == "2x1")
+			{
+				entry.shadingRate = ShadingRate::Rate2x1;
+			}
+			else if (shadingRate == "1x2")
+			{
+				entry.shadingRate = ShadingRate::Rate1x2;
+			}
+			else if (shadingRate == "2x2")
+			{
+				entry.shadingRate = ShadingRate::Rate2x2;
+			}
+			else if (!shadingRate.empty() && shadingRate != "1x1")
+			{
+				std::cout << "SceneFile: mesh \"" << entry.name << "\" uses unknown shading rate \"" << shadingRate << "\" in " << m_Path << '\n';
+				return false;
+			}
+
+			m_Meshes.emplace_back(std::move(entry));
+		}
+
+		return true;
+	}
+
+	bool SceneFile::ReadInstance(const JsonValue& instance)
+	{
+		// { "mesh": "<name>" or ["<name>", ...], "position": [x, y, z], "rotation": [pitch, yaw, roll] in degrees, "scale": s or [x, y, z],
+		//   "count": n, "columns": c, "spacing": [x, z] }
+		// A count above one places the copies on a grid in the XZ plane, starting at the position
+		std::vector<MeshEntry*> pMeshes{};
+		const JsonValue& mesh{ instance["mesh"] };
+		const size_t nrMeshes{ mesh.IsArray() ? mesh.GetSize() : 1 };
+		for (size_t i{ 0 }; i < nrMeshes; ++i)
+		{
+			const std::string& name{ mesh.IsArray() ? mesh[i].AsString() : mesh.AsString() };
+
+			MeshEntry* pMesh{ FindMesh(name) };
+			if (!pMesh)
+			{
+				std::cout << "SceneFile: instance of unknown mesh \"" << name << "\" in " << m_Path << '\n';
+				return false;
+			}
+			pMeshes.emplace_back(pMesh);
+		}
+
+		const int count{ instance["count"].AsInt(1) };
+		if (count < 0 || count > m_MaxInstanceCount)
+		{
+			std::cout << "SceneFile: instance count " << count << " out of range in " << m_Path << '\n';
+			return false;
+		}
+
+		const Vector3 position{ ReadVector3(instance["position"], Vector3::Zero) };
+		const Vector3 rotation{ ReadVector3(instance["rotation"], Vector3::Zero) * TO_RADIANS };
+
+		const JsonValue& scale{ instance["scale"] };
+		const float uniformScale{ scale.AsFloat(1.f) };
+		const Matrix scaleRotation{ Matrix::CreateScale(ReadVector3(scale, { uniformScale, uniformScale, uniformScale })) * Matrix::CreateRotation(rotation) };
+
+		const int columns{ std::max(instance["columns"].AsInt(static_cast<int>(std::ceil(std::sqrt(static_cast<float>(count))))), 1) };
+		const JsonValue& spacing{ instance["spacing"] };
+		const float spacingX{ spacing[0].AsFloat() };
+		const float spacingZ{ spacing[1].AsFloat() };
+
+		for (MeshEntry* pMesh : pMeshes)
+		{
+			pMesh->instances.reserve(pMesh->instances.size() + count);
+			for (int i{ 0 }; i < count; ++i)
+			{
+				const Vector3 offset{ static_cast<float>(i % columns) * spacingX, 0.f, static_cast<float>(i / columns) * spacingZ };
+				pMesh->instances.emplace_back(scaleRotation * Matrix::CreateTranslation(position + offset));
+			}
+		}
+
+		return true;
+	}
+
+	Vector3 SceneFile::ReadVector3(const JsonValue& value, const Vector3& fallback)
+	{
+		if (!value.IsArray() || value.GetSize() != 3) return fallback;
+
+		return { value[0].AsFloat(), value[1].AsFloat(), value[2].AsFloat() };
+	}
+}
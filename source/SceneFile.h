@@ -0,0 +1,78 @@
+#pragma once
+#include "DataTypes.h"
+
+namespace dae
+{
+	class JsonValue;
+
+	// Scene description, a JSON file listing the materials, meshes and instances to load.
+	// Meshes and materials are declared once by name, instances only reference them,
+	// so a mesh placed a thousand times is still loaded a single time.
+	class SceneFile final
+	{
+	public:
+		enum class EffectType
+		{
+			Phong,
+			Fire
+		};
+
+		// Texture paths, an empty path keeps the texture of the effect
+		struct MaterialEntry
+		{
+			std::string name{};
+			std::string diffuse{};
+			std::string normal{};
+			std::string gloss{};
+			std::string specular{};
+		};
+
+		struct MeshEntry
+		{
+			std::string name{};
+			// .obj or .glb, a .glb brings its own materials
+			std::string path{};
+			std::string material{};
+			EffectType effect{ EffectType::Phong };
+			// The fire effect is not rendered by the software rasterizer
+			bool software{ true };
+			ShadingRate shadingRate{ ShadingRate::Rate1x1 };
+
+			// World matrix of every instance of the mesh
+			std::vector<Matrix> instances{};
+		};
+
+		SceneFile() = default;
+		~SceneFile() = default;
+
+		SceneFile(const SceneFile&) = delete;
+		SceneFile(SceneFile&&) noexcept = delete;
+		SceneFile& operator=(const SceneFile&) = delete;
+		SceneFile& operator=(SceneFile&&) noexcept = delete;
+
+		// Returns false and prints the reason when the file is missing, invalid or references an unknown name
+		bool Load(const std::string& path);
+
+		// Getters
+		const std::vector<MaterialEntry>& GetMaterials() const { return m_Materials; }
+		const std::vector<MeshEntry>& GetMeshes() const { return m_Meshes; }
+		const MaterialEntry* FindMaterial(const std::string& name) const;
+
+	private:
+		std::string m_Path{};
+
+		std::vector<MaterialEntry> m_Materials{};
+		std::vector<MeshEntry> m_Meshes{};
+
+		// Upper bound on the count of a single instance entry, guards against typos
+		static constexpr int m_MaxInstanceCount{ 1'000'000 };
+
+		bool ReadMaterials(const JsonValue& materials);
+		bool ReadMeshes(const JsonValue& meshes);
+		bool ReadInstance(const JsonValue& instance);
+
+		MeshEntry* FindMesh(const std::string& name);
+
+		static Vector3 ReadVector3(const JsonValue& value, const Vector3& fallback);
+	};
+}
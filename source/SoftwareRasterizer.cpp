@@ -1,14 +1,22 @@
 #include "pch.h"
 #include "SoftwareRasterizer.h"
 
+#include <bit>
+#include <cassert>
+#include <immintrin.h>
+
 #include "DataTypes.h"
 #include "Mesh.h"
+#include "StreamingMesh.h"
 #include "Texture.h"
 #include "Camera.h"
+#include "Frustum.h"
 
 namespace dae {
 	SoftwareRasterizer::SoftwareRasterizer(SDL_Window* pWindow)
-		: m_pWindow{ pWindow }
+		: m_pWindow{ pWindow },
+		// The render thread bins the draws while the other cores transform vertices, all of them render the bins
+		m_ThreadPool{ std::max(std::thread::hardware_concurrency(), 2u) - 1 }
 	{
 		//Initialize
 		SDL_GetWindowSize(pWindow, &m_Width, &m_Height);
@@ -17,17 +25,33 @@ namespace dae {
 
 		//Create Buffers
 		m_pFrontBuffer = SDL_GetWindowSurface(pWindow);
-		m_pBackBuffer = SDL_CreateRGBSurface(0, m_Width, m_Height, 32, 0, 0, 0, 0);
+		// The bins pack their colors as 0x00RRGGBB and copy them as they are
+		m_pBackBuffer = SDL_CreateRGBSurface(0, m_Width, m_Height, 32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0);
 		m_pBackBufferPixels = static_cast<uint32_t*>(m_pBackBuffer->pixels);
-		m_pDepthBufferPixels = new float[m_Width * m_Height];
 
-		ClearDepthBuffer();
-	}
+		m_DrawSlots.resize(m_ThreadPool.GetNrThreads() * m_DrawSlotsPerThread);
 
-	SoftwareRasterizer::~SoftwareRasterizer()
-	{
-		delete[] m_pDepthBufferPixels;
-		m_pDepthBufferPixels = nullptr;
+		m_BinsX = (m_Width + m_BinSize - 1) / m_BinSize;
+		m_BinsY = (m_Height + m_BinSize - 1) / m_BinSize;
+		m_Bins.resize(m_BinsX * m_BinsY);
+
+		constexpr int nrDepthBlocks{ (m_BinSize / m_DepthBlockSize) * (m_BinSize / m_DepthBlockSize) };
+		m_BinBuffers.resize(m_ThreadPool.GetNrThreads() + 1);
+		for (BinBuffers& buffers : m_BinBuffers)
+		{
+			buffers.colors.resize(m_BinSize * m_BinSize);
+			// Room for the widest depth format
+			buffers.depths.resize(m_BinSize * m_BinSize * sizeof(uint32_t));
+			buffers.isDepthBlockCleared.resize(nrDepthBlocks);
+			buffers.coverages.resize(m_BinSize * m_BinSize);
+			buffers.coveredRows.resize(m_BinSize);
+			buffers.coveredRowDepths.resize(m_BinSize * sizeof(uint32_t));
+			buffers.coarseColors.resize(m_BinSize * m_BinSize);
+			buffers.coarseTriangles.resize(m_BinSize * m_BinSize);
+		}
+
+		m_ShadingRateTilesX = (m_Width + m_ShadingRateTileSize - 1) / m_ShadingRateTileSize;
+		m_ShadingRates.resize(m_ShadingRateTilesX * ((m_Height + m_ShadingRateTileSize - 1) / m_ShadingRateTileSize));
 	}
 
 	void SoftwareRasterizer::Render(const ColorRGB& clearColor)
@@ -36,19 +60,104 @@ namespace dae {
 		//Lock BackBuffer
 		SDL_LockSurface(m_pBackBuffer);
 
-		ClearDepthBuffer();
-		ClearBackBuffer(clearColor);
+		for (std::vector<BinEntry>& bin : m_Bins)
+		{
+			bin.clear();
+		}
+		m_BinnedDraws.clear();
+		m_NrFrameTransformedDraws = 0;
+
+		const Matrix viewProjMatrix{ m_pCamera->GetViewMatrix() * m_pCamera->GetProjectionMatrix() };
+		const Frustum frustum{ Frustum::FromViewProjection(viewProjMatrix) };
+
+		// The BVH rejects and accepts whole groups of instances, the boxes of the remaining ones are culled eight at a time.
+		// Instances come out roughly front to back, which is enough to pick the nearest occluders.
+		UpdateInstanceBvh();
+
+		m_VisibleInstances.clear();
+		m_FrustumCuller.Clear();
+		m_InstanceBvh.QueryFrustum(frustum, m_pCamera->GetPosition(), [this](uint32_t item, bool isInside)
+			{
+				if (isInside)
+				{
+					m_VisibleInstances.emplace_back(item, -1);
+					return;
+				}
+
+				const Bvh::Box& box{ m_InstanceBvh.GetBox(item) };
+				m_VisibleInstances.emplace_back(item, static_cast<int>(m_FrustumCuller.GetCount()));
+				m_FrustumCuller.AddBox(box.min, box.max);
+			});
+		m_FrustumCuller.Cull(frustum, m_IsInstanceVisible);
 
-		for (int idx{ 0 }; const auto & mesh : m_pMeshes)
+		m_DrawItems.clear();
+		for (const VisibleInstance& visibleInstance : m_VisibleInstances)
 		{
-			m_CurrentMeshIndex = idx;
+			if (visibleInstance.cullIndex >= 0 && !m_IsInstanceVisible[visibleInstance.cullIndex]) continue;
 
-			VertexTransformationFunction(m_pMeshes);
-			RenderMesh(mesh);
+			m_DrawItems.emplace_back(visibleInstance.item);
+		}
+
+		if (m_UseOcclusionCulling) CullOccludedInstances(viewProjMatrix);
+
+		m_FrameDraws.clear();
+		m_FrameDrawDepths.clear();
+		for (const uint32_t item : m_DrawItems)
+		{
+			// Instances share the vertices of the mesh, only the world matrix differs
+			const Mesh* pMesh{ m_InstanceItems[item].pMesh };
+
+			DrawCall draw{};
+			draw.worldMatrix = m_InstanceWorldMatrices[item];
+			draw.viewProjMatrix = pMesh->GetViewProjMatrix();
+			draw.pMaterial = &pMesh->GetMaterial();
+			draw.topology = pMesh->GetPrimitiveTopology();
+			draw.cacheItem = item;
+			draw.shadingRate = pMesh->GetShadingRate();
+
+			const MeshLod& lod{ pMesh->GetLod(m_UseLods ? SelectLod(pMesh, draw.worldMatrix, m_MaxLodPixelError) : 0) };
+
+			const CompactVertices& compactVertices{ lod.compactVertices };
+			if (m_UseCompactVertices && !compactVertices.vertices.empty())
+			{
+				draw.pCompactVertices = &compactVertices;
+				if (!compactVertices.indices16.empty())
+					draw.pIndices16 = &compactVertices.indices16;
+				else
+					draw.pIndices32 = &compactVertices.indices32;
+			}
+			else
+			{
+				draw.pVertices = &lod.vertices;
+				draw.pIndices32 = &lod.indices;
+			}
 
-			++idx;
+			AddFrameDraw(draw, m_InstanceBvh.GetBox(item));
+		}
+
+		// Streaming meshes only draw the clusters that are visible and resident
+		for (const StreamingMesh* pStreamingMesh : m_pStreamingMeshes)
+		{
+			for (const StreamingMesh::ResidentCluster* pCluster : pStreamingMesh->GetVisibleClusters())
+			{
+				DrawCall draw{};
+				draw.pVertices = &pCluster->vertices;
+				draw.worldMatrix = pStreamingMesh->GetWorldMatrix();
+				draw.viewProjMatrix = viewProjMatrix;
+				draw.pMaterial = &pStreamingMesh->GetMaterial();
+				draw.pIndices32 = &pCluster->indices;
+
+				AddFrameDraw(draw, Bvh::TransformBox(pCluster->boundsMin, pCluster->boundsMax, draw.worldMatrix));
+			}
 		}
 
+		SubmitFrameDrawsFrontToBack();
+
+		// The draws point into the meshes, so they have to be finished before the meshes can change
+		FlushDraws();
+		RenderBins(clearColor);
+		TrimTransformCache();
+
 		//@END
 		//Update SDL Surface
 		SDL_UnlockSurface(m_pBackBuffer);
@@ -89,275 +198,1685 @@ namespace dae {
 		}
 	}
 
-	void SoftwareRasterizer::ClearDepthBuffer() const
+	void SoftwareRasterizer::CycleSampleCount()
 	{
-		std::fill_n(m_pDepthBufferPixels, m_Width * m_Height, FLT_MAX);
+		m_SampleCount = m_SampleCount == m_MaxSampleCount ? 1 : m_SampleCount * 2;
+
+		// The sample buffers of the bins are only kept while multisampling
+		const size_t nrSamples{ m_SampleCount > 1 ? static_cast<size_t>(m_BinSize * m_BinSize * m_SampleCount) : 0 };
+		for (BinBuffers& buffers : m_BinBuffers)
+		{
+			buffers.sampleDepths.resize(nrSamples > 0 ? (nrSamples + m_MaxSampleCount) * sizeof(uint32_t) : 0);
+			buffers.sampleDepths.shrink_to_fit();
+			buffers.sampleColors.resize(nrSamples);
+			buffers.sampleColors.shrink_to_fit();
+		}
+
+		// Set console text color to purple
+		SetConsoleTextAttribute(GetStdHandle(STD_OUTPUT_HANDLE), 5);
+		std::cout << "**(SOFTWARE) MSAA = " << m_SampleCount << "X\n";
 	}
 
-	void SoftwareRasterizer::ClearBackBuffer(const ColorRGB& clearColor) const
+	void SoftwareRasterizer::CycleDepthFormat()
 	{
-		SDL_FillRect
-		(
-			m_pBackBuffer,
-			nullptr,
-			SDL_MapRGB(
-				m_pBackBuffer->format,
-				static_cast<Uint8>(clearColor.r * 255),
-				static_cast<Uint8>(clearColor.g * 255),
-				static_cast<Uint8>(clearColor.b * 255)
-			)
-		);
+		static constexpr int enumSize{ 4 };
+		m_DepthFormat = static_cast<DepthFormat>((static_cast<int>(m_DepthFormat) + 1) % enumSize);
+
+		// Set console text color to purple
+		SetConsoleTextAttribute(GetStdHandle(STD_OUTPUT_HANDLE), 5);
+
+		std::cout << "**(SOFTWARE) Depth Format = ";
+
+		switch (m_DepthFormat)
+		{
+		case DepthFormat::Float:
+			std::cout << "FLOAT\n";
+			break;
+		case DepthFormat::ReversedFloat:
+			std::cout << "REVERSED_FLOAT\n";
+			break;
+		case DepthFormat::Unorm24:
+			std::cout << "UNORM24\n";
+			break;
+		case DepthFormat::Unorm16:
+			std::cout << "UNORM16\n";
+			break;
+		}
 	}
 
-	void SoftwareRasterizer::RenderMesh(const Mesh* pMesh) const
+	void SoftwareRasterizer::CycleShadingRateMode()
 	{
-		const bool isTriangleList{ pMesh->GetPrimitiveTopology() == PrimitiveTopology::TriangleList };
+		static constexpr int enumSize{ 3 };
+		m_ShadingRateMode = static_cast<ShadingRateMode>((static_cast<int>(m_ShadingRateMode) + 1) % enumSize);
 
-		const int increment{ isTriangleList ? 3 : 1 };
-		const size_t size{ isTriangleList ? pMesh->GetIndices().size() : pMesh->GetIndices().size() - 2 };
+		// The rate image starts at full rate, it was not kept up to date while contrast mode was off
+		if (m_ShadingRateMode == ShadingRateMode::Contrast) std::ranges::fill(m_ShadingRates, ShadingRate::Rate1x1);
 
-		for (int i{ 0 }; i < size; i += increment)
+		// Set console text color to purple
+		SetConsoleTextAttribute(GetStdHandle(STD_OUTPUT_HANDLE), 5);
+
+		std::cout << "**(SOFTWARE) Variable Rate Shading = ";
+
+		switch (m_ShadingRateMode)
 		{
-			const uint32_t& idx0{ pMesh->GetIndices()[i] };
-			const uint32_t& idx1{ pMesh->GetIndices()[i + 1] };
-			const uint32_t& idx2{ pMesh->GetIndices()[i + 2] };
+		case ShadingRateMode::Off:
+			std::cout << "OFF\n";
+			break;
+		case ShadingRateMode::PerDraw:
+			std::cout << "PER_DRAW\n";
+			break;
+		case ShadingRateMode::Contrast:
+			std::cout << "CONTRAST\n";
+			break;
+		}
+	}
 
-			// If any of the indexes are equal skip
-			if (idx0 == idx1 || idx1 == idx2 || idx2 == idx0) continue;
+	void SoftwareRasterizer::SubmitDraw(const DrawCall& draw)
+	{
+		// Reuse the oldest slot, its draw is binned first so the draws stay in submission order
+		DrawSlot& slot{ m_DrawSlots[m_NextDrawSlot] };
+		m_NextDrawSlot = (m_NextDrawSlot + 1) % m_DrawSlots.size();
+
+		if (slot.isPending) BinDraw(slot);
+
+		slot.draw = draw;
+		slot.isPending = true;
+		slot.pTransformed = AcquireTransformedDraw(draw);
+
+		// Nothing moved since the draw was last transformed, it is binned straight from the cache
+		if (IsTransformUpToDate(draw, *slot.pTransformed))
+		{
+			slot.transformed = {};
+			return;
+		}
+
+		slot.transformed = m_ThreadPool.Enqueue([this, &slot] { TransformDraw(slot.draw, *slot.pTransformed); });
+	}
 
-			const Vertex_Out& v0{ pMesh->GetVerticesOut()[idx0] };
-			const Vertex_Out& v1{ pMesh->GetVerticesOut()[idx1] };
-			const Vertex_Out& v2{ pMesh->GetVerticesOut()[idx2] };
+	SoftwareRasterizer::TransformedDraw* SoftwareRasterizer::AcquireTransformedDraw(const DrawCall& draw)
+	{
+		TransformedDraw* pTransformed{ nullptr };
+		if (draw.cacheItem != m_UncachedItem)
+		{
+			const TransformKey key{ draw.pCompactVertices ? static_cast<const void*>(draw.pCompactVertices) : draw.pVertices, draw.cacheItem };
 
-			if (isTriangleList)
+			auto it{ m_TransformCache.find(key) };
+			if (it == m_TransformCache.end())
 			{
-				RenderTriangle(v0, v1, v2);
-				continue;
+				// Past the budget the draw falls back to the buffers of the frame
+				const size_t bytes{ EstimateTransformedBytes(draw) };
+				if (m_TransformCacheBytes + bytes <= m_TransformCacheBudget)
+				{
+					it = m_TransformCache.emplace(key, std::make_unique<TransformedDraw>()).first;
+					m_TransformCacheBytes += bytes;
+				}
 			}
-			RenderTriangle(i % 2 == 0 ? v0 : v2, v1, i % 2 == 0 ? v2 : v0);
+			if (it != m_TransformCache.end()) pTransformed = it->second.get();
+		}
+
+		if (!pTransformed)
+		{
+			if (m_NrFrameTransformedDraws == m_FrameTransformedDraws.size()) m_FrameTransformedDraws.emplace_back(std::make_unique<TransformedDraw>());
+
+			pTransformed = m_FrameTransformedDraws[m_NrFrameTransformedDraws++].get();
+			pTransformed->isValid = false;
 		}
+
+		pTransformed->lastUsedFrame = m_FrameIndex;
+		return pTransformed;
 	}
 
-	void SoftwareRasterizer::RenderTriangle(const Vertex_Out& v0, const Vertex_Out& v1, const Vertex_Out& v2) const
+	bool SoftwareRasterizer::IsTransformUpToDate(const DrawCall& draw, const TransformedDraw& transformed) const
 	{
-		if (IsOutsideViewFrustum(v0) || IsOutsideViewFrustum(v1) || IsOutsideViewFrustum(v2)) return;
+		const size_t nrVertices{ draw.pCompactVertices ? draw.pCompactVertices->vertices.size() : draw.pVertices->size() };
+
+		return
+			transformed.isValid &&
+			transformed.verticesOut.size() == nrVertices &&
+			transformed.worldMatrix == draw.worldMatrix &&
+			transformed.viewProjMatrix == draw.viewProjMatrix &&
+			transformed.viewportWidth == m_fWidth &&
+			transformed.viewportHeight == m_fHeight &&
+			transformed.cullMode == m_CullMode &&
+			transformed.isAntiAliased == IsAntiAliased();
+	}
 
-		const Vector2& v0Pos{ v0.pos.GetXY() };
-		const Vector2& v1Pos{ v1.pos.GetXY() };
-		const Vector2& v2Pos{ v2.pos.GetXY() };
+	void SoftwareRasterizer::TransformDraw(const DrawCall& draw, TransformedDraw& transformed) const
+	{
+		// The world space attributes survive a moving camera, only a new world matrix invalidates them
+		if (!transformed.isValid || !(transformed.worldMatrix == draw.worldMatrix))
+		{
+			transformed.worldMatrix = draw.worldMatrix;
+			transformed.transformedAttributes.clear();
+		}
+		transformed.viewProjMatrix = draw.viewProjMatrix;
+		transformed.viewportWidth = m_fWidth;
+		transformed.viewportHeight = m_fHeight;
+		transformed.cullMode = m_CullMode;
+		transformed.isAntiAliased = IsAntiAliased();
+
+		if (draw.pCompactVertices)
+			TransformPositions(*draw.pCompactVertices, transformed.verticesOut, draw.worldMatrix, draw.viewProjMatrix);
+		else
+			TransformPositions(*draw.pVertices, transformed.verticesOut, draw.worldMatrix, draw.viewProjMatrix);
+
+		if (draw.pIndices16)
+			CullTriangles(transformed.verticesOut, *draw.pIndices16, draw.topology, transformed.triangles, transformed.usedVertices);
+		else
+			CullTriangles(transformed.verticesOut, *draw.pIndices32, draw.topology, transformed.triangles, transformed.usedVertices);
+
+		// Vertices only used by back facing or off screen triangles keep nothing but their position
+		transformed.transformedAttributes.resize(transformed.usedVertices.size());
+		if (draw.pCompactVertices)
+			TransformAttributes(*draw.pCompactVertices, transformed);
+		else
+			TransformAttributes(*draw.pVertices, transformed);
+
+		// Setup picks the mip level from the uvs, so it waits for the attributes
+		TriangleSetup::Setup(transformed.verticesOut, transformed.triangles, m_fWidth, m_fHeight, transformed.isAntiAliased, transformed.setups);
+
+		transformed.isValid = true;
+	}
 
-		// Calculate the bounding box - but make sure the triangle is inside the screen
-		Int2 min;
-		Int2 max;
-		CalculateBoundingBox(v0, v1, v2, min, max);
+	void SoftwareRasterizer::TrimTransformCache()
+	{
+		// Draws that were culled, switched LOD or vertex format this frame are dropped
+		m_TransformCacheBytes = 0;
+		std::erase_if(m_TransformCache, [this](const auto& entry)
+			{
+				const TransformedDraw& transformed{ *entry.second };
+				if (transformed.lastUsedFrame != m_FrameIndex) return true;
 
-		const float area{ EdgeFunction(v0Pos, v1Pos, v2Pos) };
+				m_TransformCacheBytes += GetTransformedBytes(transformed);
+				return false;
+			});
 
-		if (area == 0) return;
+		// Vectors can grow past the estimate an entry was admitted with, the cache sheds entries until it fits again
+		for (auto it{ m_TransformCache.begin() }; it != m_TransformCache.end() && m_TransformCacheBytes > m_TransformCacheBudget;)
+		{
+			m_TransformCacheBytes -= GetTransformedBytes(*it->second);
+			it = m_TransformCache.erase(it);
+		}
 
-		// Cullmode checks
-		const bool isAreaNegative{ area <= FLT_EPSILON };
-		if (isAreaNegative && m_CullMode == CullMode::Back) return;
-		else if (!isAreaNegative && m_CullMode == CullMode::Front) return;
+		++m_FrameIndex;
+	}
+
+	size_t SoftwareRasterizer::EstimateTransformedBytes(const DrawCall& draw) const
+	{
+		// Every triangle survives culling at worst
+		const size_t nrVertices{ draw.pCompactVertices ? draw.pCompactVertices->vertices.size() : draw.pVertices->size() };
+		const size_t nrIndices{ draw.pIndices16 ? draw.pIndices16->size() : draw.pIndices32->size() };
+		const size_t nrTriangles{ draw.topology == PrimitiveTopology::TriangleList ? nrIndices / 3 : std::max(nrIndices, size_t{ 2 }) - 2 };
+		const size_t nrWords{ (nrVertices + 63) / 64 };
 
-		const float invArea{ Inverse(area) };
+		return
+			nrVertices * sizeof(Vertex_Out) +
+			nrTriangles * (3 * sizeof(uint32_t) + sizeof(TriangleSetup)) +
+			2 * nrWords * sizeof(uint64_t);
+	}
 
-		// Pre-calculate the inverse z
-		const float z0{ Inverse(v0.pos.z) };
-		const float z1{ Inverse(v1.pos.z) };
-		const float z2{ Inverse(v2.pos.z) };
+	size_t SoftwareRasterizer::GetTransformedBytes(const TransformedDraw& transformed)
+	{
+		return
+			transformed.verticesOut.capacity() * sizeof(Vertex_Out) +
+			transformed.triangles.capacity() * sizeof(uint32_t) +
+			transformed.setups.capacity() * sizeof(TriangleSetup) +
+			(transformed.usedVertices.capacity() + transformed.transformedAttributes.capacity()) * sizeof(uint64_t);
+	}
 
-		// Pre-calculate the inverse w
-		const float w0V{ Inverse(v0.pos.w) };
-		const float w1V{ Inverse(v1.pos.w) };
-		const float w2V{ Inverse(v2.pos.w) };
+	void SoftwareRasterizer::BinDraw(DrawSlot& slot)
+	{
+		if (slot.transformed.valid()) slot.transformed.wait();
+		slot.isPending = false;
 
-		// Pre calculate the uv coordinates
-		const Vector2& uv0{ v0.uv / v0.pos.w };
-		const Vector2& uv1{ v1.uv / v1.pos.w };
-		const Vector2& uv2{ v2.uv / v2.pos.w };
+		const std::vector<TriangleSetup>& setups{ slot.pTransformed->setups };
+		if (setups.empty()) return;
 
-		// Pre calculate the color coordinates
-		const ColorRGB& c0{ v0.col / v0.pos.w };
-		const ColorRGB& c1{ v1.col / v1.pos.w };
-		const ColorRGB& c2{ v2.col / v2.pos.w };
+		const uint32_t draw{ static_cast<uint32_t>(m_BinnedDraws.size()) };
+		m_BinnedDraws.emplace_back(slot.pTransformed, slot.draw.pMaterial, slot.draw.shadingRate);
 
-		// Loop over the bounding box
-		for (int py{ min.y }; py < max.y; ++py)
+		// Most triangles lie inside a single bin
+		for (uint32_t i{ 0 }; i < setups.size(); ++i)
 		{
-			for (int px{ min.x }; px < max.x; ++px)
+			const TriangleSetup& setup{ setups[i] };
+			for (int binY{ setup.min.y >> m_BinShift }; binY <= (setup.max.y - 1) >> m_BinShift; ++binY)
 			{
-				// Check if the pixel is inside the triangle
-				// If so, draw the pixel
-				const Vector2 pixel{ static_cast<float>(px) + .5f, static_cast<float>(py) + .5f };
-				const int zBufferIdx{ py * m_Width + px };
-
-				if (m_RenderBoundingBox)
+				for (int binX{ setup.min.x >> m_BinShift }; binX <= (setup.max.x - 1) >> m_BinShift; ++binX)
 				{
-					m_pBackBufferPixels[zBufferIdx] = SDL_MapRGB(m_pBackBuffer->format, 255, 255, 255);
-					continue;
+					m_Bins[binY * m_BinsX + binX].emplace_back(draw, i);
 				}
+			}
+		}
+	}
 
-				const float w0{ EdgeFunction(v1Pos, v2Pos, pixel) * invArea };
-				if (w0 < .0f) continue;
+	void SoftwareRasterizer::FlushDraws()
+	{
+		// Starting at the next slot visits the pending draws from oldest to newest
+		for (size_t i{ 0 }; i < m_DrawSlots.size(); ++i)
+		{
+			DrawSlot& slot{ m_DrawSlots[(m_NextDrawSlot + i) % m_DrawSlots.size()] };
+			if (slot.isPending) BinDraw(slot);
+		}
+		m_NextDrawSlot = 0;
+	}
 
-				const float w1{ EdgeFunction(v2Pos, v0Pos, pixel) * invArea };
-				if (w1 < .0f) continue;
+	void SoftwareRasterizer::AddFrameDraw(const DrawCall& draw, const Bvh::Box& box)
+	{
+		// View depth of the nearest point of the box, zero when the camera is inside it
+		const Vector3 forward{ m_pCamera->GetInvViewMatrix()[2].GetXYZ() };
+		const Vector3 center{ (box.min + box.max) * .5f };
+		const Vector3 extents{ (box.max - box.min) * .5f };
 
-				// Optimize by not calculating the cross product for the last edge
-				const float w2{ 1.f - w0 - w1 };
-				if (w2 < .0f) continue;
+		const float centerDepth{ Vector3::Dot(center - m_pCamera->GetPosition(), forward) };
+		const float extentDepth{ std::abs(forward.x) * extents.x + std::abs(forward.y) * extents.y + std::abs(forward.z) * extents.z };
 
-				// Calculate the depth account for perspective interpolation
-				const float z{ Inverse(z0 * w0 + z1 * w1 + z2 * w2) };
-				float& zBuffer{ m_pDepthBufferPixels[zBufferIdx] };
+		m_FrameDraws.emplace_back(draw);
+		m_FrameDrawDepths.emplace_back(std::max(centerDepth - extentDepth, 0.f));
+	}
 
-				//Check if pixel is in front of the current pixel in the depth buffer
-				if (z >= zBuffer) continue;
+	void SoftwareRasterizer::SubmitFrameDrawsFrontToBack()
+	{
+		if (m_FrameDraws.empty()) return;
 
-				//Update depth buffer
-				zBuffer = z;
+		// Quantizing between the nearest and farthest draw spends all 16 bits on the depth range actually in view
+		const auto [minDepth, maxDepth] { std::ranges::minmax(m_FrameDrawDepths) };
+		const float depthScale{ maxDepth > minDepth ? 65535.f / (maxDepth - minDepth) : 0.f };
+
+		m_DrawOrder.resize(m_FrameDraws.size());
+		for (uint32_t i{ 0 }; i < m_FrameDraws.size(); ++i)
+		{
+			m_DrawOrder[i] = { static_cast<uint16_t>((m_FrameDrawDepths[i] - minDepth) * depthScale), i };
+		}
+		m_DrawSorter.Sort(m_DrawOrder);
+
+		for (const RadixSort::Entry& entry : m_DrawOrder)
+		{
+			SubmitDraw(m_FrameDraws[entry.value]);
+		}
+	}
+
+	bool SoftwareRasterizer::PickInstance(int x, int y, InstancePick& pick)
+	{
+		pick = {};
+		UpdateInstanceBvh();
+
+		// Ray through the center of the pixel, from the camera into the scene
+		const Matrix projectionMatrix{ m_pCamera->GetProjectionMatrix() };
+		const Vector3 viewDirection
+		{
+			(2.f * (static_cast<float>(x) + .5f) / m_fWidth - 1.f) / projectionMatrix[0][0],
+			(1.f - 2.f * (static_cast<float>(y) + .5f) / m_fHeight) / projectionMatrix[1][1],
+			1.f
+		};
+		const Vector3 origin{ m_pCamera->GetPosition() };
+		const Vector3 direction{ m_pCamera->GetInvViewMatrix().TransformVector(viewDirection).Normalized() };
+
+		m_InstanceBvh.Raycast(origin, direction, FLT_MAX, [&](uint32_t item, float& maxDistance)
+			{
+				// An affine transform keeps the distance along the ray, so the hit can be tested in object space
+				const InstanceItem& instanceItem{ m_InstanceItems[item] };
+				const Matrix inverseWorldMatrix{ Matrix::Inverse(m_InstanceWorldMatrices[item]) };
+
+				const float distance{ instanceItem.pMesh->IntersectRay(inverseWorldMatrix.TransformPoint(origin), inverseWorldMatrix.TransformVector(direction), maxDistance) };
+				if (distance >= maxDistance) return;
+
+				maxDistance = distance;
+				pick = { instanceItem.pMesh, instanceItem.instance, distance };
+			});
 
-				ColorRGB finalColor{ colors::Black };
+		return pick.pMesh != nullptr;
+	}
+
+	void SoftwareRasterizer::UpdateInstanceBvh()
+	{
+		// Adding meshes or changing the number of instances of a mesh changes the items, the tree is then built again
+		bool needsRebuild{ !m_IsInstanceBvhValid || m_MeshFirstItems.size() != m_pMeshes.size() };
+		for (size_t mesh{ 0 }; !needsRebuild && mesh < m_pMeshes.size(); ++mesh)
+		{
+			const size_t lastItem{ mesh + 1 < m_MeshFirstItems.size() ? m_MeshFirstItems[mesh + 1] : m_InstanceItems.size() };
+			needsRebuild = m_pMeshes[mesh]->GetInstanceCount() != lastItem - m_MeshFirstItems[mesh];
+		}
 
-				if (m_RenderDepthBuffer)
+		if (needsRebuild)
+		{
+			m_InstanceItems.clear();
+			m_MeshFirstItems.clear();
+			m_MeshTransformVersions.clear();
+			for (const Mesh* pMesh : m_pMeshes)
+			{
+				m_MeshFirstItems.emplace_back(static_cast<uint32_t>(m_InstanceItems.size()));
+				m_MeshTransformVersions.emplace_back(pMesh->GetTransformVersion());
+				for (uint32_t instance{ 0 }; instance < pMesh->GetInstanceCount(); ++instance)
 				{
-					const float depthColor{ Remap(z, .997f, 1.f) };
-					finalColor = colors::White * depthColor;
+					m_InstanceItems.emplace_back(pMesh, instance);
 				}
-				else
-				{
-					// Interpolated w
-					const float w{ Inverse(w0V * w0 + w1V * w1 + w2V * w2) };
+			}
 
-					Vertex_Out interpolatedVertex
-					{
-						{ pixel.x, pixel.y, z, w },
-						((v0.norm * w0 + v1.norm * w1 + v2.norm * w2) * w).Normalized(),
-						((v0.tan * w0 + v1.tan * w1 + v2.tan * w2) * w).Normalized(),
-						(uv0 * w0 + uv1 * w1 + uv2 * w2) * w,
-						c0 * w0 + c1 * w1 + c2 * w2,
-						((v0.view * w0 + v1.view * w1 + v2.view * w2) * w).Normalized()
-					};
-
-					finalColor = PixelShading(interpolatedVertex);
-				}
+			m_InstanceWorldMatrices.resize(m_InstanceItems.size());
+			std::vector<Bvh::Box> boxes(m_InstanceItems.size());
+			for (uint32_t item{ 0 }; item < boxes.size(); ++item)
+			{
+				boxes[item] = UpdateInstanceItem(item);
+			}
+
+			m_InstanceBvh.Build(boxes);
+			m_IsInstanceBvhValid = true;
+			return;
+		}
 
-				//Update Color in Buffer
-				finalColor.MaxToOne();
+		// Only the instances of meshes that moved are refit
+		for (size_t mesh{ 0 }; mesh < m_pMeshes.size(); ++mesh)
+		{
+			const uint32_t transformVersion{ m_pMeshes[mesh]->GetTransformVersion() };
+			if (transformVersion == m_MeshTransformVersions[mesh]) continue;
 
-				m_pBackBufferPixels[zBufferIdx] = SDL_MapRGB(m_pBackBuffer->format,
-					static_cast<uint8_t>(finalColor.r * 255),
-					static_cast<uint8_t>(finalColor.g * 255),
-					static_cast<uint8_t>(finalColor.b * 255));
+			m_MeshTransformVersions[mesh] = transformVersion;
+			for (uint32_t item{ m_MeshFirstItems[mesh] }; item < m_MeshFirstItems[mesh] + m_pMeshes[mesh]->GetInstanceCount(); ++item)
+			{
+				m_InstanceBvh.SetBox(item, UpdateInstanceItem(item));
 			}
 		}
+
+		m_InstanceBvh.Refit();
 	}
 
-	ColorRGB SoftwareRasterizer::PixelShading(const Vertex_Out& v) const
+	Bvh::Box SoftwareRasterizer::UpdateInstanceItem(uint32_t item)
 	{
-		const Texture* pDiffuse{ m_pMeshes[m_CurrentMeshIndex]->GetDiffuse() };
-		const Texture* pGloss{ m_pMeshes[m_CurrentMeshIndex]->GetGloss() };
-		const Texture* pNormal{ m_pMeshes[m_CurrentMeshIndex]->GetNormal() };
-		const Texture* pSpecular{ m_pMeshes[m_CurrentMeshIndex]->GetSpecular() };
+		const InstanceItem& instanceItem{ m_InstanceItems[item] };
+		m_InstanceWorldMatrices[item] = instanceItem.pMesh->GetInstanceWorldMatrix(instanceItem.instance);
 
-		// Sampled texture colors
-		const ColorRGB sampledColor{ (pDiffuse ? pDiffuse->Sample(v.uv) : colors::Black) };
-		const ColorRGB sampledNormal{ (pNormal ? pNormal->Sample(v.uv) : colors::Black) };
-		const ColorRGB sampledSpecular{ (pSpecular ? pSpecular->Sample(v.uv) : colors::Black) };
-		const ColorRGB sampledGloss{ (pGloss ? pGloss->Sample(v.uv) : colors::Black) };
+		return Bvh::TransformBox(instanceItem.pMesh->GetBoundsMin(), instanceItem.pMesh->GetBoundsMax(), m_InstanceWorldMatrices[item]);
+	}
 
-		// Normal mapping
-		const Vector3 binormal{ Vector3::Cross(v.norm, v.tan) };
-		const Matrix tangentSpaceAxis{ v.tan, binormal, v.norm, Vector3::Zero };
-		const Vector3 normal{ m_RenderNormalMap ? (tangentSpaceAxis.TransformVector(2.f * sampledNormal.ToVector3() - Vector3::One).Normalized()) : v.norm };
+	void SoftwareRasterizer::CullOccludedInstances(const Matrix& viewProjMatrix)
+	{
+		m_OcclusionBuffer.Clear();
 
-		const ColorRGB diffuse{ m_LightingData.intensity * sampledColor / PI };
+		// Instances come front to back, so the first large ones are the nearest occluders.
+		// They are drawn with the coarsest LOD that stays within a pixel of the occlusion buffer.
+		const float maxOccluderPixelError{ m_MaxLodPixelError * m_fHeight / static_cast<float>(OcclusionBuffer::m_Height) };
 
-		const float observedArea{ std::max(Vector3::Dot(normal, -m_LightingData.direction), .0f) };
+		size_t nrOccluders{ 0 };
+		for (const uint32_t item : m_DrawItems)
+		{
+			if (nrOccluders == m_MaxOccluders) break;
 
-		// Calculate diffuse and specular lighting
-		const float exp{ sampledGloss.r * m_LightingData.shininess };
-		const ColorRGB specular{ (colors::White * sampledSpecular * powf(std::max(Vector3::Dot(Vector3::Reflect(-m_LightingData.direction, normal), v.view), .0f), exp)) };
+			const Mesh* pMesh{ m_InstanceItems[item].pMesh };
+			const Matrix& worldMatrix{ m_InstanceWorldMatrices[item] };
+			if (GetProjectedRadius(pMesh, worldMatrix) < m_MinOccluderScreenSize * m_fHeight) continue;
 
-		switch (m_ShadingMode)
+			const MeshLod& lod{ pMesh->GetLod(SelectLod(pMesh, worldMatrix, maxOccluderPixelError)) };
+			m_OcclusionBuffer.RenderOccluder(lod.vertices, lod.indices, pMesh->GetPrimitiveTopology(), worldMatrix * viewProjMatrix);
+			++nrOccluders;
+		}
+
+		if (nrOccluders == 0) return;
+
+		std::erase_if(m_DrawItems, [this, &viewProjMatrix](uint32_t item)
+			{
+				return m_OcclusionBuffer.IsBoxOccluded(m_InstanceBvh.GetBox(item), viewProjMatrix);
+			});
+	}
+
+	float SoftwareRasterizer::GetProjectedRadius(const Mesh* pMesh, const Matrix& worldMatrix) const
+	{
+		// Bounding sphere in world space, scaled by the largest axis of the world matrix
+		const float scale{ std::max(worldMatrix[0].GetXYZ().Magnitude(), std::max(worldMatrix[1].GetXYZ().Magnitude(), worldMatrix[2].GetXYZ().Magnitude())) };
+		const Vector3 center{ worldMatrix.TransformPoint(pMesh->GetBoundingSphereCenter()) };
+		const float radius{ pMesh->GetBoundingSphereRadius() * scale };
+
+		const float distance{ (center - m_pCamera->GetPosition()).Magnitude() };
+		if (distance <= radius) return FLT_MAX;
+
+		return radius / distance * m_pCamera->GetProjectionMatrix()[1][1] * m_fHeight * .5f;
+	}
+
+	int SoftwareRasterizer::SelectLod(const Mesh* pMesh, const Matrix& worldMatrix, float maxPixelError) const
+	{
+		const float objectRadius{ pMesh->GetBoundingSphereRadius() };
+		const float projectedRadius{ GetProjectedRadius(pMesh, worldMatrix) };
+		if (projectedRadius == FLT_MAX || objectRadius <= 0.f) return 0;
+
+		// Pick the coarsest LOD whose error, relative to the size of the mesh, stays below the pixel threshold
+		int lod{ 0 };
+		for (int i{ 1 }; i < pMesh->GetLodCount(); ++i)
 		{
-			using enum ShadingMode;
-		case ObservedArea:
-			return { observedArea, observedArea, observedArea };
-		case Diffuse:
-			return observedArea * diffuse;
-		case Specular:
-			return specular;
-		case Combined:
-			return observedArea * diffuse + specular + m_LightingData.ambient;
+			const float pixelError{ pMesh->GetLod(i).error / objectRadius * projectedRadius };
+			if (pixelError > maxPixelError) break;
+
+			lod = i;
 		}
 
-		return colors::Black;
+		return lod;
 	}
 
-	float SoftwareRasterizer::EdgeFunction(const Vector2& a, const Vector2& b, const Vector2& c)
+	void SoftwareRasterizer::RenderBins(const ColorRGB& clearColor)
 	{
-		return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+		// The workers and the render thread take bins until none are left
+		m_NextBin = 0;
+
+		std::vector<std::future<void>> workers{};
+		for (uint32_t i{ 0 }; i < m_ThreadPool.GetNrThreads(); ++i)
+		{
+			workers.emplace_back(m_ThreadPool.Enqueue([this, &clearColor, i] { RenderNextBins(m_BinBuffers[i], clearColor); }));
+		}
+		RenderNextBins(m_BinBuffers.back(), clearColor);
+
+		for (std::future<void>& worker : workers)
+		{
+			worker.wait();
+		}
 	}
 
-	bool SoftwareRasterizer::IsOutsideViewFrustum(const Vertex_Out& v) const
+	void SoftwareRasterizer::RenderNextBins(BinBuffers& buffers, const ColorRGB& clearColor)
 	{
-		return
-			v.pos.x < .0f || v.pos.x > m_fWidth ||
-			v.pos.y < .0f || v.pos.y > m_fHeight ||
-			v.pos.z < .0f || v.pos.z > 1.f;
+		const int nrBins{ m_BinsX * m_BinsY };
+		for (int bin{ m_NextBin++ }; bin < nrBins; bin = m_NextBin++)
+		{
+			RenderBin(bin, buffers, clearColor);
+		}
+
+		// The streaming stores of this thread have to reach the back buffer before it is presented
+		_mm_sfence();
 	}
 
-	void SoftwareRasterizer::CalculateBoundingBox(const Vertex_Out& v0, const Vertex_Out& v1, const Vertex_Out& v2, Int2& min, Int2& max) const
+	void SoftwareRasterizer::RenderBin(int bin, BinBuffers& buffers, const ColorRGB& clearColor)
 	{
-		// Compute the minimum and maximum x and y coordinates of the triangle.
-		min.x = static_cast<int>(std::floor(std::max(.0f, std::min(v0.pos.x, std::min(v1.pos.x, v2.pos.x)))));
-		min.y = static_cast<int>(std::floor(std::max(.0f, std::min(v0.pos.y, std::min(v1.pos.y, v2.pos.y)))));
-		max.x = static_cast<int>(std::ceil(std::min(m_fWidth - 1.f, std::max(v0.pos.x, std::max(v1.pos.x, v2.pos.x)))));
-		max.y = static_cast<int>(std::ceil(std::min(m_fHeight - 1.f, std::max(v0.pos.y, std::max(v1.pos.y, v2.pos.y)))));
+		buffers.min = { (bin % m_BinsX) << m_BinShift, (bin / m_BinsX) << m_BinShift };
+		buffers.max = { std::min(buffers.min.x + m_BinSize, m_Width), std::min(buffers.min.y + m_BinSize, m_Height) };
+
+		const std::vector<BinEntry>& entries{ m_Bins[bin] };
+		if (entries.empty())
+		{
+			std::ranges::fill(buffers.colors, PackColor(clearColor));
+			if (m_ShadingRateMode == ShadingRateMode::Contrast) UpdateShadingRates(buffers);
+			WriteBin(buffers);
+			return;
+		}
+
+		ClearBin(buffers, clearColor);
+
+		switch (m_DepthFormat)
+		{
+		case DepthFormat::Float:
+			RenderBinTriangles<DepthTraits<DepthFormat::Float>>(entries, buffers);
+			break;
+		case DepthFormat::ReversedFloat:
+			RenderBinTriangles<DepthTraits<DepthFormat::ReversedFloat>>(entries, buffers);
+			break;
+		case DepthFormat::Unorm24:
+			RenderBinTriangles<DepthTraits<DepthFormat::Unorm24>>(entries, buffers);
+			break;
+		case DepthFormat::Unorm16:
+			RenderBinTriangles<DepthTraits<DepthFormat::Unorm16>>(entries, buffers);
+			break;
+		}
+
+		if (IsMultisampled()) ResolveSamples(buffers);
+		if (IsEdgeAntiAliased()) ResolveCoverage(buffers, clearColor);
+
+		if (m_ShadingRateMode == ShadingRateMode::Contrast) UpdateShadingRates(buffers);
+		WriteBin(buffers);
 	}
 
-	void SoftwareRasterizer::VertexTransformationFunction(const std::vector<Mesh*>& pMeshes) const
+	void SoftwareRasterizer::ClearBin(BinBuffers& buffers, const ColorRGB& clearColor) const
 	{
-		// Compute half the width and height of the screen
-		const float halfWidth{ m_fWidth * .5f };
-		const float halfHeight{ m_fHeight * .5f };
+		if (IsEdgeAntiAliased())
+		{
+			std::ranges::fill(buffers.colors, 0u);
+			std::ranges::fill(buffers.coverages, 0.f);
+		}
+		else if (IsMultisampled())
+		{
+			std::ranges::fill(buffers.sampleColors, PackColor(clearColor));
+		}
+		else
+		{
+			std::ranges::fill(buffers.colors, PackColor(clearColor));
+		}
+	}
 
-		// Precompute the viewProjectionMatrix for this mesh.
-		const Matrix& worldMatrix{ m_pMeshes[m_CurrentMeshIndex]->GetWorldMatrix() };
-		const Matrix worldViewProjMatrix{ worldMatrix * m_pMeshes[m_CurrentMeshIndex]->GetViewProjMatrix() };
+	void SoftwareRasterizer::BinBuffers::NextTriangle()
+	{
+		// A number only comes back after every block forgot the triangle it was shaded by
+		if (++triangle == 0)
+		{
+			std::ranges::fill(coarseTriangles, 0u);
+			triangle = 1;
+		}
+	}
 
-		// Use a reference to the mesh vertices and vertices_out vectors
-		// to avoid repeated calls to the mesh accessor functions.
-		const std::vector<Vertex_In>& vertices{ m_pMeshes[m_CurrentMeshIndex]->GetVertices() };
-		std::vector<Vertex_Out>& verticesOut{ m_pMeshes[m_CurrentMeshIndex]->GetVerticesOut() };
+	template <typename Depth>
+	typename Depth::Type* SoftwareRasterizer::BinBuffers::GetDepthRow(int px, int py)
+	{
+		// Bins start at a multiple of their size, so the low bits of a pixel are its position within the bin
+		const int x{ px & (m_BinSize - 1) };
+		const int y{ py & (m_BinSize - 1) };
 
-		// Iterate over the vertices of the mesh using a range-based for loop.
-		for (int i{ 0 }; auto & vertex : verticesOut)
+		const int block{ (y >> m_DepthBlockShift) * (m_BinSize >> m_DepthBlockShift) + (x >> m_DepthBlockShift) };
+		typename Depth::Type* pBlock{ reinterpret_cast<typename Depth::Type*>(depths.data()) + block * m_DepthBlockSize * m_DepthBlockSize };
+		if (isDepthBlockCleared[block])
 		{
-			// Transform the vertex position using the precomputed viewProjectionMatrix
-			vertex.pos = worldViewProjMatrix.TransformPoint({ vertices[i].pos, 1.f });
+			std::fill_n(pBlock, m_DepthBlockSize * m_DepthBlockSize, Depth::m_ClearValue);
+			isDepthBlockCleared[block] = false;
+		}
+
+		return pBlock + (y & (m_DepthBlockSize - 1)) * m_DepthBlockSize;
+	}
 
-			// Transform the normal and tangent vectors using the world matrix of the mesh
-			vertex.norm = worldMatrix.TransformVector(vertices[i].norm);
-			vertex.tan = worldMatrix.TransformVector(vertices[i].tan);
+	void SoftwareRasterizer::ResolveSamples(BinBuffers& buffers) const
+	{
+		// Every pixel gets the average color of its samples
+		for (int py{ buffers.min.y }; py < buffers.max.y; ++py)
+		{
+			for (int px{ buffers.min.x }; px < buffers.max.x; ++px)
+			{
+				const int pixel{ buffers.GetIndex(px, py) };
+				const uint32_t* pSampleColors{ buffers.sampleColors.data() + static_cast<size_t>(pixel) * m_SampleCount };
 
-			// Compute the view direction vector as the difference between the transformed vertex position
-			// and the origin of the camera.
-			vertex.view = m_pMeshes[m_CurrentMeshIndex]->GetWorldMatrix().TransformPoint(vertices[i].pos) - m_pCamera->GetPosition();
+				uint32_t red{ 0 };
+				uint32_t green{ 0 };
+				uint32_t blue{ 0 };
+				for (int sample{ 0 }; sample < m_SampleCount; ++sample)
+				{
+					red += (pSampleColors[sample] >> 16) & 0xFF;
+					green += (pSampleColors[sample] >> 8) & 0xFF;
+					blue += pSampleColors[sample] & 0xFF;
+				}
 
-			// Divide the x, y, and z coordinates of the position by the w coordinate.
-			vertex.pos.x /= vertex.pos.w;
-			vertex.pos.y /= vertex.pos.w;
-			vertex.pos.z /= vertex.pos.w;
+				buffers.colors[pixel] = (red / m_SampleCount) << 16 | (green / m_SampleCount) << 8 | blue / m_SampleCount;
+			}
+		}
+	}
 
-			// Transform the x and y coordinates of the position from normalized device coordinates
-			// to screen space coordinates.
-			vertex.pos.x = (vertex.pos.x + 1.f) * halfWidth;
-			vertex.pos.y = (1.f - vertex.pos.y) * halfHeight;
+	void SoftwareRasterizer::ResolveCoverage(BinBuffers& buffers, const ColorRGB& clearColor) const
+	{
+		for (int py{ buffers.min.y }; py < buffers.max.y; ++py)
+		{
+			for (int px{ buffers.min.x }; px < buffers.max.x; ++px)
+			{
+				const int pixel{ buffers.GetIndex(px, py) };
+				const float uncovered{ 1.f - buffers.coverages[pixel] };
+				if (uncovered <= 0.f) continue;
 
-			++i;
+				ColorRGB color{ UnpackColor(buffers.colors[pixel]) + clearColor * uncovered };
+				color.MaxToOne();
+				buffers.colors[pixel] = PackColor(color);
+			}
 		}
 	}
+
+	void SoftwareRasterizer::UpdateShadingRates(const BinBuffers& buffers)
+	{
+		// Bins are aligned to tiles, so every tile is filled by a single bin
+		for (int tileY{ buffers.min.y }; tileY < buffers.max.y; tileY += m_ShadingRateTileSize)
+		{
+			for (int tileX{ buffers.min.x }; tileX < buffers.max.x; tileX += m_ShadingRateTileSize)
+			{
+				const int width{ std::min(m_ShadingRateTileSize, buffers.max.x - tileX) };
+				const int height{ std::min(m_ShadingRateTileSize, buffers.max.y - tileY) };
+
+				int lumas[m_ShadingRateTileSize][m_ShadingRateTileSize];
+				for (int y{ 0 }; y < height; ++y)
+				{
+					for (int x{ 0 }; x < width; ++x)
+					{
+						const uint32_t color{ buffers.colors[buffers.GetIndex(tileX + x, tileY + y)] };
+						lumas[y][x] = (77 * ((color >> 16) & 0xFF) + 150 * ((color >> 8) & 0xFF) + 29 * (color & 0xFF)) >> 8;
+					}
+				}
+
+				// Every pair of neighbours is compared, also across the blocks, so a coarse tile turns fine again once detail shows up between them
+				int contrastX{ 0 };
+				int contrastY{ 0 };
+				for (int y{ 0 }; y < height; ++y)
+				{
+					for (int x{ 0 }; x < width; ++x)
+					{
+						if (x + 1 < width) contrastX = std::max(contrastX, std::abs(lumas[y][x + 1] - lumas[y][x]));
+						if (y + 1 < height) contrastY = std::max(contrastY, std::abs(lumas[y + 1][x] - lumas[y][x]));
+					}
+				}
+
+				const uint8_t rate{ static_cast<uint8_t>((contrastX < m_MaxCoarseContrast ? 1 : 0) | (contrastY < m_MaxCoarseContrast ? 2 : 0)) };
+				m_ShadingRates[(tileY >> m_ShadingRateTileShift) * m_ShadingRateTilesX + (tileX >> m_ShadingRateTileShift)] = static_cast<ShadingRate>(rate);
+			}
+		}
+	}
+
+	void SoftwareRasterizer::WriteBin(const BinBuffers& buffers) const
+	{
+		const int width{ buffers.max.x - buffers.min.x };
+		for (int py{ buffers.min.y }; py < buffers.max.y; ++py)
+		{
+			const uint32_t* pSource{ buffers.colors.data() + buffers.GetIndex(buffers.min.x, py) };
+			uint32_t* pDestination{ m_pBackBufferPixels + py * m_Width + buffers.min.x };
+
+			// Back buffer rows only stay 16 byte aligned when the width is a multiple of four pixels, unaligned rows are copied
+			int x{ 0 };
+			if (reinterpret_cast<uintptr_t>(pDestination) % sizeof(__m128i) == 0)
+			{
+				for (; x + 4 <= width; x += 4)
+				{
+					_mm_stream_si128(reinterpret_cast<__m128i*>(pDestination + x), _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSource + x)));
+				}
+			}
+			std::copy(pSource + x, pSource + width, pDestination + x);
+		}
+	}
+
+	uint32_t SoftwareRasterizer::PackColor(const ColorRGB& color)
+	{
+		return
+			static_cast<uint32_t>(color.r * 255) << 16 |
+			static_cast<uint32_t>(color.g * 255) << 8 |
+			static_cast<uint32_t>(color.b * 255);
+	}
+
+	ColorRGB SoftwareRasterizer::UnpackColor(uint32_t color)
+	{
+		return
+		{
+			static_cast<float>((color >> 16) & 0xFF) / 255.f,
+			static_cast<float>((color >> 8) & 0xFF) / 255.f,
+			static_cast<float>(color & 0xFF) / 255.f
+		};
+	}
+
+	const SoftwareRasterizer::SamplePattern& SoftwareRasterizer::GetSamplePattern() const
+	{
+		// The standard Direct3D sample positions, relative to the pixel center
+		static constexpr SamplePattern patterns[]
+		{
+			{ { 0.f }, { 0.f } },
+			{ { .25f, -.25f }, { .25f, -.25f } },
+			{ { -.125f, .375f, -.375f, .125f }, { -.375f, -.125f, .125f, .375f } },
+			{ { .0625f, -.0625f, .3125f, -.1875f, -.3125f, -.4375f, .1875f, .4375f }, { -.1875f, .1875f, .0625f, -.3125f, .3125f, -.0625f, .4375f, -.4375f } }
+		};
+
+		return patterns[std::countr_zero(static_cast<uint32_t>(m_SampleCount))];
+	}
+
+	template <typename Index>
+	void SoftwareRasterizer::CullTriangles(const std::vector<Vertex_Out>& verticesOut, const std::vector<Index>& indices, PrimitiveTopology topology, std::vector<uint32_t>& triangles, std::vector<uint64_t>& usedVertices) const
+	{
+		const bool isTriangleList{ topology == PrimitiveTopology::TriangleList };
+
+		const int increment{ isTriangleList ? 3 : 1 };
+		const size_t size{ isTriangleList ? indices.size() : indices.size() - 2 };
+
+		triangles.clear();
+		usedVertices.assign((verticesOut.size() + 63) / 64, 0);
+
+		for (int i{ 0 }; i < size; i += increment)
+		{
+			uint32_t idx0{ indices[i] };
+			const uint32_t idx1{ indices[i + 1] };
+			uint32_t idx2{ indices[i + 2] };
+
+			// If any of the indexes are equal skip
+			if (idx0 == idx1 || idx1 == idx2 || idx2 == idx0) continue;
+
+			// Every other triangle of a strip has its winding flipped
+			if (!isTriangleList && i % 2 != 0) std::swap(idx0, idx2);
+
+			if (!IsTriangleVisible(verticesOut[idx0], verticesOut[idx1], verticesOut[idx2])) continue;
+
+			triangles.insert(triangles.end(), { idx0, idx1, idx2 });
+			usedVertices[idx0 / 64] |= 1ull << (idx0 % 64);
+			usedVertices[idx1 / 64] |= 1ull << (idx1 % 64);
+			usedVertices[idx2 / 64] |= 1ull << (idx2 % 64);
+		}
+	}
+
+	bool SoftwareRasterizer::IsTriangleVisible(const Vertex_Out& v0, const Vertex_Out& v1, const Vertex_Out& v2) const
+	{
+		if (IsOutsideViewFrustum(v0) || IsOutsideViewFrustum(v1) || IsOutsideViewFrustum(v2)) return false;
+
+		const float area{ EdgeFunction(v0.pos.GetXY(), v1.pos.GetXY(), v2.pos.GetXY()) };
+		if (area == 0) return false;
+
+		// Cullmode checks
+		const bool isAreaNegative{ area <= FLT_EPSILON };
+		if (isAreaNegative && m_CullMode == CullMode::Back) return false;
+		if (!isAreaNegative && m_CullMode == CullMode::Front) return false;
+
+		return true;
+	}
+
+	template <typename Depth>
+	void SoftwareRasterizer::RenderBinTriangles(const std::vector<BinEntry>& entries, BinBuffers& buffers) const
+	{
+		// The depth blocks are cleared once a triangle touches them, the samples up front
+		std::ranges::fill(buffers.isDepthBlockCleared, uint8_t{ 1 });
+		if (IsMultisampled()) std::fill_n(reinterpret_cast<typename Depth::Type*>(buffers.sampleDepths.data()), m_BinSize * m_BinSize * m_SampleCount + m_MaxSampleCount, Depth::m_ClearValue);
+
+		if (IsCoverageBuffered())
+		{
+			RenderCoveredBinTriangles<Depth>(entries, buffers);
+			return;
+		}
+
+		for (const BinEntry& entry : entries)
+		{
+			const BinnedDraw& draw{ m_BinnedDraws[entry.draw] };
+			const TriangleSetup& setup{ draw.pTransformed->setups[entry.setup] };
+			buffers.NextTriangle();
+
+			if (IsMultisampled())
+			{
+				RenderMultisampledTriangle<Depth>(setup, draw, buffers);
+				continue;
+			}
+
+			// The bounding box view draws every pixel of the box and edge anti-aliasing blends partially covered ones,
+			// which only the general path does
+			if (m_RenderBoundingBox || IsEdgeAntiAliased())
+			{
+				RenderTriangle<Depth>(setup, draw, buffers);
+				continue;
+			}
+
+			switch (setup.path)
+			{
+			case RasterPath::Micro:
+				RenderMicroTriangle<Depth>(setup, draw, buffers);
+				break;
+			case RasterPath::BoundingBox:
+				RenderTriangle<Depth>(setup, draw, buffers);
+				break;
+			case RasterPath::Span:
+				RenderSpanTriangle<Depth>(setup, draw, buffers);
+				break;
+			}
+		}
+	}
+
+	template <typename Depth>
+	void SoftwareRasterizer::RenderTriangle(const TriangleSetup& setup, const BinnedDraw& draw, BinBuffers& buffers) const
+	{
+		// Only triangles that passed IsTriangleVisible get here, bounding box, weights, depth and w come from the setup stage.
+		// The planes stay relative to the box, only the part of it inside the bin is visited.
+		const Int2& min{ setup.min };
+		const Int2 first{ std::max(min.x, buffers.min.x), std::max(min.y, buffers.min.y) };
+		const Int2 last{ std::min(setup.max.x, buffers.max.x), std::min(setup.max.y, buffers.max.y) };
+
+		AttributePlanes attributePlanes{};
+		SetupAttributePlanes(setup, draw, attributePlanes);
+
+		// A weight divided by the length of its gradient is the distance to the opposite edge in pixels.
+		// With edge anti-aliasing, pixels whose center lies up to half a pixel outside an edge are still partially covered.
+		const bool isEdgeAntiAliased{ IsEdgeAntiAliased() };
+		const float edgeScales[3]
+		{
+			1.f / std::sqrt(Square(setup.weight0.a) + Square(setup.weight0.b)),
+			1.f / std::sqrt(Square(setup.weight1.a) + Square(setup.weight1.b)),
+			1.f / std::sqrt(Square(setup.weight0.a + setup.weight1.a) + Square(setup.weight0.b + setup.weight1.b))
+		};
+		const float minWeights[3]
+		{
+			isEdgeAntiAliased ? -.5f / edgeScales[0] : 0.f,
+			isEdgeAntiAliased ? -.5f / edgeScales[1] : 0.f,
+			isEdgeAntiAliased ? -.5f / edgeScales[2] : 0.f
+		};
+
+		// Loop over the bounding box
+		for (int py{ first.y }; py < last.y; ++py)
+		{
+			const float dy{ static_cast<float>(py - min.y) };
+
+			// Every plane is stepped to the start of the row once, the pixels of the row then need one multiply add per attribute
+			float rowValues[m_MaxAttributeFloats];
+			for (int i{ 0 }; i < attributePlanes.nrPlanes; ++i)
+			{
+				rowValues[i] = attributePlanes.planes[i].Evaluate(0.f, dy);
+			}
+
+			for (int px{ first.x }; px < last.x; ++px)
+			{
+				// Check if the pixel is inside the triangle
+				// If so, draw the pixel
+				const float dx{ static_cast<float>(px - min.x) };
+
+				if (m_RenderBoundingBox)
+				{
+					WritePixel(buffers, px, py, colors::White);
+					continue;
+				}
+
+				const float w0{ setup.weight0.Evaluate(dx, dy) };
+				if (w0 < minWeights[0]) continue;
+
+				const float w1{ setup.weight1.Evaluate(dx, dy) };
+				if (w1 < minWeights[1]) continue;
+
+				// Optimize by not calculating the cross product for the last edge
+				const float w2{ 1.f - w0 - w1 };
+				if (w2 < minWeights[2]) continue;
+
+				// Every edge covers the part of the pixel on its inner side, as if the edge crossed the pixel straight
+				float coverage{ 1.f };
+				if (isEdgeAntiAliased)
+				{
+					coverage =
+						std::min(w0 * edgeScales[0] + .5f, 1.f) *
+						std::min(w1 * edgeScales[1] + .5f, 1.f) *
+						std::min(w2 * edgeScales[2] + .5f, 1.f);
+					if (coverage <= 0.f) continue;
+				}
+
+				// Calculate the depth account for perspective interpolation
+				const typename Depth::Type depth{ Depth::Encode(setup.inverseDepth.Evaluate(dx, dy), setup.inverseW.Evaluate(dx, dy)) };
+				typename Depth::Type& zBuffer{ buffers.GetDepth<Depth>(px, py) };
+
+				//Check if pixel is in front of the current pixel in the depth buffer
+				// With edge anti-aliasing, a pixel behind still shows through the part that is not covered yet
+				const bool isInFront{ Depth::IsNearer(depth, zBuffer) };
+				if (!isInFront && (!isEdgeAntiAliased || buffers.coverages[buffers.GetIndex(px, py)] >= 1.f)) continue;
+
+				//Update depth buffer
+				if (isInFront) zBuffer = depth;
+
+				ColorRGB color{};
+				const ShadingRate rate{ GetShadingRate(draw, px, py) };
+				if (rate != ShadingRate::Rate1x1)
+				{
+					color = ShadeCoarsePixel(setup, attributePlanes, buffers, rate, px, py);
+				}
+				else
+				{
+					const float z{ Inverse(setup.inverseDepth.Evaluate(dx, dy)) };
+
+					// Interpolated w
+					const float w{ Inverse(setup.inverseW.Evaluate(dx, dy)) };
+
+					float values[m_MaxAttributeFloats];
+					for (int i{ 0 }; i < attributePlanes.nrPlanes; ++i)
+					{
+						values[i] = (rowValues[i] + attributePlanes.planes[i].a * dx) * w;
+					}
+
+					color = ShadePixel(px, py, z, w, attributePlanes, values, setup.uvLod);
+				}
+
+				if (isEdgeAntiAliased)
+					BlendPixel(buffers, px, py, color, coverage, isInFront);
+				else
+					WritePixel(buffers, px, py, color);
+			}
+		}
+	}
+
+	template <typename Depth>
+	void SoftwareRasterizer::RenderMicroTriangle(const TriangleSetup& setup, const BinnedDraw& draw, BinBuffers& buffers) const
+	{
+		// All candidate pixel centers are tested without early outs, a candidate past the box repeats the last pixel and is masked off.
+		// Candidates in a neighbouring bin are masked off as well, that bin renders them.
+		constexpr int maxPixels{ TriangleSetup::m_MaxMicroPixels };
+		const int nrColumns{ setup.max.x - setup.min.x };
+		const int nrPixels{ nrColumns * (setup.max.y - setup.min.y) };
+
+		float dxs[maxPixels];
+		float dys[maxPixels];
+		typename Depth::Type depths[maxPixels];
+		bool isCovered[maxPixels];
+		for (int i{ 0 }; i < maxPixels; ++i)
+		{
+			const int pixel{ std::min(i, nrPixels - 1) };
+			dxs[i] = static_cast<float>(pixel % nrColumns);
+			dys[i] = static_cast<float>(pixel / nrColumns);
+
+			const float w0{ setup.weight0.Evaluate(dxs[i], dys[i]) };
+			const float w1{ setup.weight1.Evaluate(dxs[i], dys[i]) };
+			depths[i] = Depth::Encode(setup.inverseDepth.Evaluate(dxs[i], dys[i]), setup.inverseW.Evaluate(dxs[i], dys[i]));
+
+			const int px{ setup.min.x + static_cast<int>(dxs[i]) };
+			const int py{ setup.min.y + static_cast<int>(dys[i]) };
+			const bool isInBin{ px >= buffers.min.x && px < buffers.max.x && py >= buffers.min.y && py < buffers.max.y };
+			isCovered[i] = (i < nrPixels) & isInBin & (w0 >= 0.f) & (w1 >= 0.f) & (1.f - w0 - w1 >= 0.f) && Depth::IsNearer(depths[i], buffers.GetDepth<Depth>(px, py));
+		}
+
+		// Most micro triangles end here, before any attribute is set up
+		if (std::ranges::none_of(isCovered, std::identity{})) return;
+
+		AttributePlanes attributePlanes{};
+		SetupAttributePlanes(setup, draw, attributePlanes);
+
+		for (int i{ 0 }; i < maxPixels; ++i)
+		{
+			if (!isCovered[i]) continue;
+
+			const int px{ setup.min.x + static_cast<int>(dxs[i]) };
+			const int py{ setup.min.y + static_cast<int>(dys[i]) };
+			buffers.GetDepth<Depth>(px, py) = depths[i];
+
+			const ShadingRate rate{ GetShadingRate(draw, px, py) };
+			if (rate != ShadingRate::Rate1x1)
+			{
+				WritePixel(buffers, px, py, ShadeCoarsePixel(setup, attributePlanes, buffers, rate, px, py));
+				continue;
+			}
+
+			const float z{ Inverse(setup.inverseDepth.Evaluate(dxs[i], dys[i])) };
+			const float w{ Inverse(setup.inverseW.Evaluate(dxs[i], dys[i])) };
+
+			float values[m_MaxAttributeFloats];
+			for (int plane{ 0 }; plane < attributePlanes.nrPlanes; ++plane)
+			{
+				values[plane] = attributePlanes.planes[plane].Evaluate(dxs[i], dys[i]) * w;
+			}
+
+			WritePixel(buffers, px, py, ShadePixel(px, py, z, w, attributePlanes, values, setup.uvLod));
+		}
+	}
+
+	template <typename Depth>
+	void SoftwareRasterizer::RenderCoveredBinTriangles(const std::vector<BinEntry>& entries, BinBuffers& buffers) const
+	{
+		std::ranges::fill(buffers.coveredRows, uint64_t{ 0 });
+
+		// The draws already come nearest first and keep their order, the triangles of a draw are put in order by their nearest vertex.
+		// Inverse depth is linear over the triangle, so its largest value lies on one of the vertices.
+		// The order only makes it likely that nearer triangles fill a row first, the depth test still settles every pixel.
+		buffers.sortedEntries.clear();
+		for (uint32_t i{ 0 }; i < entries.size(); ++i)
+		{
+			const BinEntry& entry{ entries[i] };
+			const TransformedDraw& transformed{ *m_BinnedDraws[entry.draw].pTransformed };
+			const TriangleSetup& setup{ transformed.setups[entry.setup] };
+
+			float nearest{ 0.f };
+			for (const uint32_t index : setup.indices)
+			{
+				nearest = std::max(nearest, 1.f / transformed.verticesOut[index].pos.z);
+			}
+
+			buffers.sortedEntries.push_back({ i, entry.draw, nearest });
+		}
+		std::ranges::sort(buffers.sortedEntries, [](const SortedEntry& a, const SortedEntry& b)
+			{
+				if (a.draw != b.draw) return a.draw < b.draw;
+				if (a.nearestInverseDepth != b.nearestInverseDepth) return a.nearestInverseDepth > b.nearestInverseDepth;
+				return a.entry < b.entry;
+			});
+
+		for (const SortedEntry& sorted : buffers.sortedEntries)
+		{
+			const BinEntry& entry{ entries[sorted.entry] };
+			const BinnedDraw& draw{ m_BinnedDraws[entry.draw] };
+			buffers.NextTriangle();
+			RenderCoveredTriangle<Depth>(draw.pTransformed->setups[entry.setup], draw, buffers);
+		}
+	}
+
+	template <typename Depth>
+	void SoftwareRasterizer::RenderCoveredTriangle(const TriangleSetup& setup, const BinnedDraw& draw, BinBuffers& buffers) const
+	{
+		static_assert(m_BinSize <= 64, "A row of a bin is covered by the bits of one uint64_t");
+
+		const Int2& min{ setup.min };
+		const int binWidth{ buffers.max.x - buffers.min.x };
+		const uint64_t binRow{ binWidth == 64 ? ~uint64_t{ 0 } : (uint64_t{ 1 } << binWidth) - 1 };
+		typename Depth::Type* pRowDepths{ reinterpret_cast<typename Depth::Type*>(buffers.coveredRowDepths.data()) };
+
+		// Nearest depth of the triangle, found on one of its vertices like the inverse depth it is encoded from
+		const std::vector<Vertex_Out>& verticesOut{ draw.pTransformed->verticesOut };
+		typename Depth::Type nearest{ Depth::m_ClearValue };
+		for (const uint32_t index : setup.indices)
+		{
+			const typename Depth::Type depth{ Depth::Encode(1.f / verticesOut[index].pos.z, 1.f / verticesOut[index].pos.w) };
+			if (Depth::IsNearer(depth, nearest)) nearest = depth;
+		}
+
+		AttributePlanes attributePlanes{};
+		bool hasAttributePlanes{ false };
+
+		for (int py{ std::max(min.y, buffers.min.y) }; py < std::min(setup.max.y, buffers.max.y); ++py)
+		{
+			uint64_t& coveredRow{ buffers.coveredRows[py - buffers.min.y] };
+			typename Depth::Type& rowDepth{ pRowDepths[py - buffers.min.y] };
+
+			// Only pixels nearer than the farthest one written to the row can change the covered ones
+			const bool isNearerThanRow{ coveredRow != 0 && Depth::IsNearer(nearest, rowDepth) };
+			if (coveredRow == binRow && !isNearerThanRow) continue;
+
+			const float dy{ static_cast<float>(py - min.y) };
+
+			int first{};
+			int last{};
+			if (!FindRowSpan(setup, dy, first, last)) continue;
+
+			// Bits of the span in the row of the bin, the ends are settled on the whole row like the span path does
+			first = std::max(first + min.x - buffers.min.x, 0);
+			last = std::min(last + min.x - buffers.min.x, binWidth - 1);
+			if (first > last) continue;
+
+			const uint64_t span{ (~uint64_t{ 0 } >> (63 - last)) & (~uint64_t{ 0 } << first) };
+			uint64_t pixels{ isNearerThanRow ? span : span & ~coveredRow };
+			if (pixels == 0) continue;
+
+			const float rowInverseDepth{ setup.inverseDepth.Evaluate(0.f, dy) };
+			const float rowInverseW{ setup.inverseW.Evaluate(0.f, dy) };
+
+			for (; pixels != 0; pixels &= pixels - 1)
+			{
+				const int bit{ std::countr_zero(pixels) };
+				const int px{ buffers.min.x + bit };
+				const float dx{ static_cast<float>(px - min.x) };
+
+				const float inverseDepth{ rowInverseDepth + setup.inverseDepth.a * dx };
+				const float inverseW{ rowInverseW + setup.inverseW.a * dx };
+				const typename Depth::Type depth{ Depth::Encode(inverseDepth, inverseW) };
+				typename Depth::Type& zBuffer{ buffers.GetDepth<Depth>(px, py) };
+				if (!Depth::IsNearer(depth, zBuffer)) continue;
+
+				zBuffer = depth;
+				if (coveredRow == 0 || Depth::IsNearer(rowDepth, depth)) rowDepth = depth;
+				coveredRow |= uint64_t{ 1 } << bit;
+
+				// Triangles hidden by the ones before them never set up their attributes
+				if (!hasAttributePlanes)
+				{
+					SetupAttributePlanes(setup, draw, attributePlanes);
+					hasAttributePlanes = true;
+				}
+
+				const ShadingRate rate{ GetShadingRate(draw, px, py) };
+				if (rate != ShadingRate::Rate1x1)
+				{
+					WritePixel(buffers, px, py, ShadeCoarsePixel(setup, attributePlanes, buffers, rate, px, py));
+					continue;
+				}
+
+				const float w{ Inverse(inverseW) };
+
+				float values[m_MaxAttributeFloats];
+				for (int i{ 0 }; i < attributePlanes.nrPlanes; ++i)
+				{
+					values[i] = attributePlanes.planes[i].Evaluate(dx, dy) * w;
+				}
+
+				WritePixel(buffers, px, py, ShadePixel(px, py, Inverse(inverseDepth), w, attributePlanes, values, setup.uvLod));
+			}
+		}
+	}
+
+	bool SoftwareRasterizer::FindRowSpan(const TriangleSetup& setup, float dy, int& first, int& last)
+	{
+		const int nrColumns{ setup.max.x - setup.min.x };
+
+		// The weight of the third vertex is one minus the other two, so its plane is too
+		const ScreenPlane& weight0{ setup.weight0 };
+		const ScreenPlane& weight1{ setup.weight1 };
+		const ScreenPlane weight2{ -weight0.a - weight1.a, -weight0.b - weight1.b, 1.f - weight0.c - weight1.c };
+
+		// Same test as the bounding box path, used to settle the ends of a span exactly
+		const auto isCovered{ [&](int dx)
+			{
+				const float w0{ weight0.Evaluate(static_cast<float>(dx), dy) };
+				const float w1{ weight1.Evaluate(static_cast<float>(dx), dy) };
+				return w0 >= 0.f && w1 >= 0.f && 1.f - w0 - w1 >= 0.f;
+			} };
+
+		// Every edge bounds the row on one side, where its weight crosses zero
+		float left{ 0.f };
+		float right{ static_cast<float>(nrColumns - 1) };
+		for (const ScreenPlane* pEdge : { &weight0, &weight1, &weight2 })
+		{
+			const float rowValue{ pEdge->Evaluate(0.f, dy) };
+			if (pEdge->a > 0.f)
+				left = std::max(left, -rowValue / pEdge->a);
+			else if (pEdge->a < 0.f)
+				right = std::min(right, -rowValue / pEdge->a);
+			else if (rowValue < 0.f)
+				right = -1.f;
+		}
+		if (left > right + 1.f)
+		{
+			first = 0;
+			last = -1;
+		}
+		else
+		{
+			// The divisions can be off by a rounding error, the end pixels are moved until they agree with the exact test
+			first = std::max(static_cast<int>(std::ceil(left)), 0);
+			last = std::min(static_cast<int>(std::floor(right)), nrColumns - 1);
+			while (first <= last && !isCovered(first)) ++first;
+			while (first > 0 && isCovered(first - 1)) --first;
+			// The estimates can cross on a row of a single pixel, so the last pixel is walked from the one before the first
+			last = std::max(last, first - 1);
+			while (last >= first && !isCovered(last)) --last;
+			while (last < nrColumns - 1 && isCovered(last + 1)) ++last;
+		}
+
+#if defined(DEBUG) || defined(_DEBUG)
+		// The span has to hold exactly the pixels the bounding box path covers, or the paths leave cracks or overlaps between triangles
+		for (int dx{ 0 }; dx < nrColumns; ++dx)
+		{
+			assert(isCovered(dx) == (dx >= first && dx <= last) && "ERROR: row span does not match the bounding box coverage test");
+		}
+#endif
+
+		return first <= last;
+	}
+
+	template <typename Depth>
+	void SoftwareRasterizer::RenderSpanTriangle(const TriangleSetup& setup, const BinnedDraw& draw, BinBuffers& buffers) const
+	{
+		const Int2& min{ setup.min };
+		const Int2& max{ setup.max };
+
+		AttributePlanes attributePlanes{};
+		SetupAttributePlanes(setup, draw, attributePlanes);
+
+		const __m256 laneOffsets{ _mm256_setr_ps(0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f) };
+		const __m256i laneIndices{ _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7) };
+		const __m256 one{ _mm256_set1_ps(1.f) };
+		const __m256 depthStep{ _mm256_set1_ps(setup.inverseDepth.a) };
+		const __m256 inverseWStep{ _mm256_set1_ps(setup.inverseW.a) };
+
+		for (int py{ std::max(min.y, buffers.min.y) }; py < std::min(max.y, buffers.max.y); ++py)
+		{
+			const float dy{ static_cast<float>(py - min.y) };
+
+			int first{};
+			int last{};
+			if (!FindRowSpan(setup, dy, first, last)) continue;
+
+			// The ends are settled on the whole row, so neighbouring bins agree on them
+			first = std::max(first, buffers.min.x - min.x);
+			last = std::min(last, buffers.max.x - 1 - min.x);
+			if (first > last) continue;
+
+			float rowValues[m_MaxAttributeFloats];
+			for (int i{ 0 }; i < attributePlanes.nrPlanes; ++i)
+			{
+				rowValues[i] = attributePlanes.planes[i].Evaluate(0.f, dy);
+			}
+
+			const __m256 rowDepth{ _mm256_set1_ps(setup.inverseDepth.Evaluate(0.f, dy)) };
+			const __m256 rowInverseW{ _mm256_set1_ps(setup.inverseW.Evaluate(0.f, dy)) };
+			const __m256i spanFirst{ _mm256_set1_epi32(first - 1) };
+			const __m256i spanEnd{ _mm256_set1_epi32(last + 1) };
+
+			// Depth is interpolated and tested a block row of eight pixels at a time, only the pixels that pass are shaded
+			for (int dx{ ((min.x + first) & ~(m_DepthBlockSize - 1)) - min.x }; dx <= last; dx += m_DepthBlockSize)
+			{
+				const __m256i laneDx{ _mm256_add_epi32(_mm256_set1_epi32(dx), laneIndices) };
+				const __m256i isLaneInSpan{ _mm256_and_si256(_mm256_cmpgt_epi32(laneDx, spanFirst), _mm256_cmpgt_epi32(spanEnd, laneDx)) };
+				const __m256 pixelX{ _mm256_add_ps(_mm256_set1_ps(static_cast<float>(dx)), laneOffsets) };
+
+				// The whole block row belongs to this bin, so the lanes outside the span are written back unchanged
+				typename Depth::Type* pDepthRow{ buffers.GetDepthRow<Depth>(min.x + dx, py) };
+				const __m256 inverseDepth{ _mm256_fmadd_ps(depthStep, pixelX, rowDepth) };
+				const __m256 inverseW{ _mm256_fmadd_ps(inverseWStep, pixelX, rowInverseW) };
+				const __m256 depth{ Depth::Encode8(inverseDepth, inverseW) };
+				const __m256 currentDepth{ Depth::Load8(pDepthRow) };
+				const __m256 isVisible{ _mm256_and_ps(Depth::IsNearer8(depth, currentDepth), _mm256_castsi256_ps(isLaneInSpan)) };
+
+				int visibleLanes{ _mm256_movemask_ps(isVisible) };
+				if (visibleLanes == 0) continue;
+
+				Depth::Store8(pDepthRow, _mm256_blendv_ps(currentDepth, depth, isVisible));
+
+				alignas(32) float depths[8];
+				alignas(32) float ws[8];
+				_mm256_store_ps(depths, _mm256_div_ps(one, inverseDepth));
+				_mm256_store_ps(ws, _mm256_div_ps(one, inverseW));
+
+				for (; visibleLanes != 0; visibleLanes &= visibleLanes - 1)
+				{
+					const int lane{ std::countr_zero(static_cast<uint32_t>(visibleLanes)) };
+					const int px{ min.x + dx + lane };
+
+					const ShadingRate rate{ GetShadingRate(draw, px, py) };
+					if (rate != ShadingRate::Rate1x1)
+					{
+						WritePixel(buffers, px, py, ShadeCoarsePixel(setup, attributePlanes, buffers, rate, px, py));
+						continue;
+					}
+
+					const float pixelDx{ static_cast<float>(dx + lane) };
+
+					float values[m_MaxAttributeFloats];
+					for (int i{ 0 }; i < attributePlanes.nrPlanes; ++i)
+					{
+						values[i] = (rowValues[i] + attributePlanes.planes[i].a * pixelDx) * ws[lane];
+					}
+
+					WritePixel(buffers, px, py, ShadePixel(px, py, depths[lane], ws[lane], attributePlanes, values, setup.uvLod));
+				}
+			}
+		}
+	}
+
+	template <typename Depth>
+	void SoftwareRasterizer::RenderMultisampledTriangle(const TriangleSetup& setup, const BinnedDraw& draw, BinBuffers& buffers) const
+	{
+		const Int2& min{ setup.min };
+		const Int2 first{ std::max(min.x, buffers.min.x), std::max(min.y, buffers.min.y) };
+		const Int2 last{ std::min(setup.max.x, buffers.max.x), std::min(setup.max.y, buffers.max.y) };
+
+		AttributePlanes attributePlanes{};
+		SetupAttributePlanes(setup, draw, attributePlanes);
+
+		// One lane per sample, the lanes past the sample count stay masked off
+		const SamplePattern& pattern{ GetSamplePattern() };
+		const __m256 sampleX{ _mm256_loadu_ps(pattern.x) };
+		const __m256 sampleY{ _mm256_loadu_ps(pattern.y) };
+		const __m256i isSampleLane{ _mm256_cmpgt_epi32(_mm256_set1_epi32(m_SampleCount), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)) };
+
+		const auto evaluate{ [](const ScreenPlane& plane, __m256 x, __m256 y)
+			{
+				return _mm256_fmadd_ps(_mm256_set1_ps(plane.a), x, _mm256_fmadd_ps(_mm256_set1_ps(plane.b), y, _mm256_set1_ps(plane.c)));
+			} };
+
+		const __m256 one{ _mm256_set1_ps(1.f) };
+		const __m256 zero{ _mm256_setzero_ps() };
+
+		for (int py{ first.y }; py < last.y; ++py)
+		{
+			const float dy{ static_cast<float>(py - min.y) };
+			const __m256 y{ _mm256_add_ps(_mm256_set1_ps(dy), sampleY) };
+
+			for (int px{ first.x }; px < last.x; ++px)
+			{
+				const float dx{ static_cast<float>(px - min.x) };
+				const __m256 x{ _mm256_add_ps(_mm256_set1_ps(dx), sampleX) };
+
+				// Coverage of every sample at once
+				const __m256 w0{ evaluate(setup.weight0, x, y) };
+				const __m256 w1{ evaluate(setup.weight1, x, y) };
+				const __m256 w2{ _mm256_sub_ps(_mm256_sub_ps(one, w0), w1) };
+
+				__m256 isCovered{ _mm256_and_ps(_mm256_cmp_ps(w0, zero, _CMP_GE_OQ), _mm256_cmp_ps(w1, zero, _CMP_GE_OQ)) };
+				isCovered = _mm256_and_ps(isCovered, _mm256_cmp_ps(w2, zero, _CMP_GE_OQ));
+				isCovered = _mm256_and_ps(isCovered, _mm256_castsi256_ps(isSampleLane));
+				if (_mm256_movemask_ps(isCovered) == 0) continue;
+
+				// Depth is tested per sample against the samples of the pixel, which lie next to each other.
+				// Lanes past the sample count read the samples of the next pixel and write them back unchanged.
+				typename Depth::Type* pSampleDepths{ buffers.GetSampleDepths<Depth>(px, py, m_SampleCount) };
+				const __m256 depth{ Depth::Encode8(evaluate(setup.inverseDepth, x, y), evaluate(setup.inverseW, x, y)) };
+				const __m256 currentDepth{ Depth::Load8(pSampleDepths) };
+				const __m256 isVisible{ _mm256_and_ps(isCovered, Depth::IsNearer8(depth, currentDepth)) };
+
+				int visibleSamples{ _mm256_movemask_ps(isVisible) };
+				if (visibleSamples == 0) continue;
+
+				Depth::Store8(pSampleDepths, _mm256_blendv_ps(currentDepth, depth, isVisible));
+
+				// Shaded once at the pixel center, or once per coarse block, the color goes to every visible sample
+				ColorRGB shadedColor{};
+				const ShadingRate rate{ GetShadingRate(draw, px, py) };
+				if (rate != ShadingRate::Rate1x1)
+				{
+					shadedColor = ShadeCoarsePixel(setup, attributePlanes, buffers, rate, px, py);
+				}
+				else
+				{
+					const float z{ Inverse(setup.inverseDepth.Evaluate(dx, dy)) };
+					const float w{ Inverse(setup.inverseW.Evaluate(dx, dy)) };
+
+					float values[m_MaxAttributeFloats];
+					for (int i{ 0 }; i < attributePlanes.nrPlanes; ++i)
+					{
+						values[i] = attributePlanes.planes[i].Evaluate(dx, dy) * w;
+					}
+
+					shadedColor = ShadePixel(px, py, z, w, attributePlanes, values, setup.uvLod);
+				}
+
+				const uint32_t color{ PackColor(shadedColor) };
+				uint32_t* pSampleColors{ buffers.sampleColors.data() + static_cast<size_t>(buffers.GetIndex(px, py)) * m_SampleCount };
+				for (; visibleSamples != 0; visibleSamples &= visibleSamples - 1)
+				{
+					pSampleColors[std::countr_zero(static_cast<uint32_t>(visibleSamples))] = color;
+				}
+			}
+		}
+	}
+
+	void SoftwareRasterizer::SetupAttributePlanes(const TriangleSetup& setup, const BinnedDraw& draw, AttributePlanes& attributePlanes) const
+	{
+		// Planes of the attributes divided by w, set up once per triangle and only for the attributes the shading mode reads
+		const std::vector<Vertex_Out>& verticesOut{ draw.pTransformed->verticesOut };
+		const Vertex_Out& v0{ verticesOut[setup.indices[0]] };
+		const Vertex_Out& v1{ verticesOut[setup.indices[1]] };
+		const Vertex_Out& v2{ verticesOut[setup.indices[2]] };
+
+		attributePlanes.pMaterial = draw.pMaterial;
+		attributePlanes.attributes = m_RenderDepthBuffer || m_RenderBoundingBox ? 0 : GetShadedAttributes(*draw.pMaterial);
+		attributePlanes.nrPlanes = 0;
+
+		const float inverseW0{ Inverse(v0.pos.w) };
+		const float inverseW1{ Inverse(v1.pos.w) };
+		const float inverseW2{ Inverse(v2.pos.w) };
+
+		const auto addPlanes{ [&](const Vector3& a0, const Vector3& a1, const Vector3& a2, int nrComponents)
+			{
+				for (int i{ 0 }; i < nrComponents; ++i)
+				{
+					attributePlanes.planes[attributePlanes.nrPlanes++] = setup.CreatePlane(a0[i] * inverseW0, a1[i] * inverseW1, a2[i] * inverseW2);
+				}
+			} };
+
+		const uint32_t attributes{ attributePlanes.attributes };
+		if (attributes & AttributeNormal) addPlanes(v0.norm, v1.norm, v2.norm, 3);
+		if (attributes & AttributeTangent) addPlanes(v0.tan, v1.tan, v2.tan, 3);
+		if (attributes & AttributeUV) addPlanes({ v0.uv.x, v0.uv.y, 0.f }, { v1.uv.x, v1.uv.y, 0.f }, { v2.uv.x, v2.uv.y, 0.f }, 2);
+		if (attributes & AttributeColor) addPlanes(v0.col.ToVector3(), v1.col.ToVector3(), v2.col.ToVector3(), 3);
+		if (attributes & AttributeWorldPos) addPlanes(v0.worldPos, v1.worldPos, v2.worldPos, 3);
+	}
+
+	ColorRGB SoftwareRasterizer::ShadePixel(int px, int py, float z, float w, const AttributePlanes& attributePlanes, const float* pValues, float uvLod) const
+	{
+		ColorRGB finalColor{ colors::Black };
+
+		if (m_RenderDepthBuffer)
+		{
+			const float depthColor{ Remap(z, .997f, 1.f) };
+			finalColor = colors::White * depthColor;
+		}
+		else
+		{
+			// Unpack in the order the planes were added, attributes the shading mode does not read keep their defaults
+			const uint32_t attributes{ attributePlanes.attributes };
+
+			Vertex_Out interpolatedVertex{};
+			interpolatedVertex.pos = { static_cast<float>(px) + .5f, static_cast<float>(py) + .5f, z, w };
+
+			if (attributes & AttributeNormal)
+			{
+				interpolatedVertex.norm = Vector3{ pValues[0], pValues[1], pValues[2] }.Normalized();
+				pValues += 3;
+			}
+			if (attributes & AttributeTangent)
+			{
+				interpolatedVertex.tan = Vector3{ pValues[0], pValues[1], pValues[2] }.Normalized();
+				pValues += 3;
+			}
+			if (attributes & AttributeUV)
+			{
+				interpolatedVertex.uv = { pValues[0], pValues[1] };
+				pValues += 2;
+			}
+			if (attributes & AttributeColor)
+			{
+				interpolatedVertex.col = { pValues[0], pValues[1], pValues[2] };
+				pValues += 3;
+			}
+
+			Vector3 viewDirection{};
+			if (attributes & AttributeWorldPos)
+			{
+				interpolatedVertex.worldPos = { pValues[0], pValues[1], pValues[2] };
+				viewDirection = (interpolatedVertex.worldPos - m_pCamera->GetPosition()).Normalized();
+			}
+
+			finalColor = PixelShading(*attributePlanes.pMaterial, interpolatedVertex, viewDirection, uvLod);
+		}
+
+		finalColor.MaxToOne();
+		return finalColor;
+	}
+
+	ShadingRate SoftwareRasterizer::GetShadingRate(const BinnedDraw& draw, int px, int py) const
+	{
+		switch (m_ShadingRateMode)
+		{
+		case ShadingRateMode::PerDraw:
+			return draw.shadingRate;
+		case ShadingRateMode::Contrast:
+		{
+			const ShadingRate tileRate{ m_ShadingRates[(py >> m_ShadingRateTileShift) * m_ShadingRateTilesX + (px >> m_ShadingRateTileShift)] };
+			return static_cast<ShadingRate>(static_cast<uint8_t>(draw.shadingRate) | static_cast<uint8_t>(tileRate));
+		}
+		default:
+			return ShadingRate::Rate1x1;
+		}
+	}
+
+	ColorRGB SoftwareRasterizer::ShadeCoarsePixel(const TriangleSetup& setup, const AttributePlanes& attributePlanes, BinBuffers& buffers, ShadingRate rate, int px, int py) const
+	{
+		const bool isCoarseX{ (static_cast<uint8_t>(rate) & 1) != 0 };
+		const bool isCoarseY{ (static_cast<uint8_t>(rate) & 2) != 0 };
+
+		// Blocks start on even pixels and bins on multiples of 64, so a block never crosses a bin
+		const int blockX{ isCoarseX ? px & ~1 : px };
+		const int blockY{ isCoarseY ? py & ~1 : py };
+		const int index{ buffers.GetIndex(blockX, blockY) };
+		if (buffers.coarseTriangles[index] == buffers.triangle) return buffers.coarseColors[index];
+
+		// The center of the block can lie outside the triangle, the planes extrapolate to it
+		const float dx{ static_cast<float>(blockX - setup.min.x) + (isCoarseX ? .5f : 0.f) };
+		const float dy{ static_cast<float>(blockY - setup.min.y) + (isCoarseY ? .5f : 0.f) };
+
+		const float z{ Inverse(setup.inverseDepth.Evaluate(dx, dy)) };
+		const float w{ Inverse(setup.inverseW.Evaluate(dx, dy)) };
+
+		float values[m_MaxAttributeFloats];
+		for (int i{ 0 }; i < attributePlanes.nrPlanes; ++i)
+		{
+			values[i] = attributePlanes.planes[i].Evaluate(dx, dy) * w;
+		}
+
+		// A block covers twice the texels of a pixel along every coarse axis
+		const float uvLod{ setup.uvLod + (isCoarseX ? .5f : 0.f) + (isCoarseY ? .5f : 0.f) };
+
+		const ColorRGB color{ ShadePixel(blockX, blockY, z, w, attributePlanes, values, uvLod) };
+		buffers.coarseTriangles[index] = buffers.triangle;
+		buffers.coarseColors[index] = color;
+		return color;
+	}
+
+	void SoftwareRasterizer::WritePixel(BinBuffers& buffers, int px, int py, const ColorRGB& color) const
+	{
+		//Update Color in Buffer
+		buffers.colors[buffers.GetIndex(px, py)] = PackColor(color);
+	}
+
+	void SoftwareRasterizer::BlendPixel(BinBuffers& buffers, int px, int py, const ColorRGB& color, float coverage, bool isInFront) const
+	{
+		const int pixel{ buffers.GetIndex(px, py) };
+		float& pixelCoverage{ buffers.coverages[pixel] };
+		ColorRGB blended{ UnpackColor(buffers.colors[pixel]) };
+
+		float weight{ coverage };
+		if (isInFront)
+		{
+			// Triangles sharing an edge cover different parts of the pixel, only coverage past a full pixel hides what is there
+			const float hidden{ std::max(pixelCoverage + coverage - 1.f, 0.f) };
+			if (hidden > 0.f) blended *= 1.f - hidden / pixelCoverage;
+			pixelCoverage = std::min(pixelCoverage + coverage, 1.f);
+		}
+		else
+		{
+			weight = std::min(coverage, 1.f - pixelCoverage);
+			pixelCoverage += weight;
+		}
+
+		blended += color * weight;
+		blended.MaxToOne();
+		buffers.colors[pixel] = PackColor(blended);
+	}
+
+	uint32_t SoftwareRasterizer::GetShadedAttributes(const Material& material) const
+	{
+		const bool hasDiffuse{ m_ShadingMode == ShadingMode::Diffuse || m_ShadingMode == ShadingMode::Combined };
+		const bool hasSpecular{ m_ShadingMode == ShadingMode::Specular || m_ShadingMode == ShadingMode::Combined };
+
+		// Every mode lights the normal, the normal map needs the tangent frame and the uv to sample it
+		uint32_t attributes{ AttributeNormal };
+		if (m_RenderNormalMap) attributes |= AttributeTangent | AttributeUV;
+
+		// Untextured meshes fall back to their vertex color
+		if (hasDiffuse) attributes |= material.pDiffuse ? AttributeUV : AttributeColor;
+
+		// Specular samples the gloss and specular maps and needs the view vector
+		if (hasSpecular) attributes |= AttributeUV | AttributeWorldPos;
+
+		return attributes;
+	}
+
+	ColorRGB SoftwareRasterizer::PixelShading(const Material& material, const Vertex_Out& v, const Vector3& viewDirection, float uvLod) const
+	{
+		const Texture* pDiffuse{ material.pDiffuse };
+		const Texture* pGloss{ material.pGloss };
+		const Texture* pNormal{ material.pNormal };
+		const Texture* pSpecular{ material.pSpecular };
+
+		// Normal mapping
+		Vector3 normal{ v.norm };
+		if (m_RenderNormalMap)
+		{
+			const ColorRGB sampledNormal{ (pNormal ? pNormal->Sample(v.uv, uvLod) : colors::Black) };
+			const Vector3 binormal{ Vector3::Cross(v.norm, v.tan) };
+			const Matrix tangentSpaceAxis{ v.tan, binormal, v.norm, Vector3::Zero };
+			normal = tangentSpaceAxis.TransformVector(2.f * sampledNormal.ToVector3() - Vector3::One).Normalized();
+		}
+
+		const float observedArea{ std::max(Vector3::Dot(normal, -m_LightingData.direction), .0f) };
+
+		// The textures are only sampled by the modes that use them, untextured meshes fall back to their vertex color
+		const auto calculateDiffuse{ [&]
+			{
+				const ColorRGB sampledColor{ (pDiffuse ? pDiffuse->Sample(v.uv, uvLod) : v.col) };
+				return m_LightingData.intensity * sampledColor / PI;
+			} };
+
+		const auto calculateSpecular{ [&]
+			{
+				const ColorRGB sampledSpecular{ (pSpecular ? pSpecular->Sample(v.uv, uvLod) : colors::Black) };
+				const ColorRGB sampledGloss{ (pGloss ? pGloss->Sample(v.uv, uvLod) : colors::Black) };
+
+				const float exp{ sampledGloss.r * m_LightingData.shininess };
+				return colors::White * sampledSpecular * powf(std::max(Vector3::Dot(Vector3::Reflect(-m_LightingData.direction, normal), viewDirection), .0f), exp);
+			} };
+
+		switch (m_ShadingMode)
+		{
+			using enum ShadingMode;
+		case ObservedArea:
+			return { observedArea, observedArea, observedArea };
+		case Diffuse:
+			return observedArea * calculateDiffuse();
+		case Specular:
+			return calculateSpecular();
+		case Combined:
+			return observedArea * calculateDiffuse() + calculateSpecular() + m_LightingData.ambient;
+		}
+
+		return colors::Black;
+	}
+
+	float SoftwareRasterizer::EdgeFunction(const Vector2& a, const Vector2& b, const Vector2& c)
+	{
+		return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+	}
+
+	bool SoftwareRasterizer::IsOutsideViewFrustum(const Vertex_Out& v) const
+	{
+		return
+			v.pos.x < .0f || v.pos.x > m_fWidth ||
+			v.pos.y < .0f || v.pos.y > m_fHeight ||
+			v.pos.z < .0f || v.pos.z > 1.f;
+	}
+
+	void SoftwareRasterizer::TransformPositions(const std::vector<Vertex_In>& vertices, std::vector<Vertex_Out>& verticesOut, const Matrix& worldMatrix, const Matrix& viewProjMatrix) const
+	{
+		// Precompute the worldViewProjectionMatrix for this mesh.
+		const Matrix worldViewProjMatrix{ worldMatrix * viewProjMatrix };
+
+		// Only the positions are written, the attributes are filled in by TransformAttributes
+		verticesOut.resize(vertices.size());
+
+		for (size_t i{ 0 }; i < vertices.size(); ++i)
+		{
+			verticesOut[i].pos = worldViewProjMatrix.TransformPoint({ vertices[i].pos, 1.f });
+			ToScreenSpace(verticesOut[i].pos);
+		}
+	}
+
+	void SoftwareRasterizer::TransformPositions(const CompactVertices& vertices, std::vector<Vertex_Out>& verticesOut, const Matrix& worldMatrix, const Matrix& viewProjMatrix) const
+	{
+		// Dequantizing the positions is folded into the matrix, so they are transformed straight from their 16 bit values
+		const Matrix worldViewProjMatrix{ vertices.decodeMatrix * worldMatrix * viewProjMatrix };
+
+		verticesOut.resize(vertices.vertices.size());
+
+		for (size_t i{ 0 }; i < vertices.vertices.size(); ++i)
+		{
+			const Vertex_Compact& compact{ vertices.vertices[i] };
+			const Vector3 position{ static_cast<float>(compact.pos[0]), static_cast<float>(compact.pos[1]), static_cast<float>(compact.pos[2]) };
+
+			verticesOut[i].pos = worldViewProjMatrix.TransformPoint({ position, 1.f });
+			ToScreenSpace(verticesOut[i].pos);
+		}
+	}
+
+	void SoftwareRasterizer::TransformAttributes(const std::vector<Vertex_In>& vertices, TransformedDraw& transformed) const
+	{
+		const Matrix& worldMatrix{ transformed.worldMatrix };
+
+		// Walk the vertices that are used but not transformed yet, whole words of them are skipped at once
+		for (size_t word{ 0 }; word < transformed.usedVertices.size(); ++word)
+		{
+			const uint64_t missing{ transformed.usedVertices[word] & ~transformed.transformedAttributes[word] };
+			transformed.transformedAttributes[word] |= missing;
+
+			for (uint64_t bits{ missing }; bits != 0; bits &= bits - 1)
+			{
+				const size_t i{ word * 64 + std::countr_zero(bits) };
+				Vertex_Out& vertex{ transformed.verticesOut[i] };
+
+				// Transform the normal and tangent vectors using the world matrix of the mesh
+				vertex.norm = worldMatrix.TransformVector(vertices[i].norm);
+				vertex.tan = worldMatrix.TransformVector(vertices[i].tan);
+				vertex.uv = vertices[i].uv;
+				vertex.col = vertices[i].col;
+				vertex.worldPos = worldMatrix.TransformPoint(vertices[i].pos);
+			}
+		}
+	}
+
+	void SoftwareRasterizer::TransformAttributes(const CompactVertices& vertices, TransformedDraw& transformed) const
+	{
+		const Matrix& worldMatrix{ transformed.worldMatrix };
+		const Matrix decodedWorldMatrix{ vertices.decodeMatrix * worldMatrix };
+
+		for (size_t word{ 0 }; word < transformed.usedVertices.size(); ++word)
+		{
+			const uint64_t missing{ transformed.usedVertices[word] & ~transformed.transformedAttributes[word] };
+			transformed.transformedAttributes[word] |= missing;
+
+			for (uint64_t bits{ missing }; bits != 0; bits &= bits - 1)
+			{
+				const size_t i{ word * 64 + std::countr_zero(bits) };
+				const Vertex_Compact& compact{ vertices.vertices[i] };
+				Vertex_Out& vertex{ transformed.verticesOut[i] };
+
+				vertex.norm = worldMatrix.TransformVector(VertexCompression::DecodeOctahedral(compact.norm));
+				vertex.tan = worldMatrix.TransformVector(VertexCompression::DecodeOctahedral(compact.tan));
+				vertex.uv = { VertexCompression::HalfToFloat(compact.uv[0]), VertexCompression::HalfToFloat(compact.uv[1]) };
+				vertex.col = VertexCompression::DecodeColor(compact.col);
+
+				const Vector3 position{ static_cast<float>(compact.pos[0]), static_cast<float>(compact.pos[1]), static_cast<float>(compact.pos[2]) };
+				vertex.worldPos = decodedWorldMatrix.TransformPoint(position);
+			}
+		}
+	}
+
+	void SoftwareRasterizer::ToScreenSpace(Vector4& position) const
+	{
+		// Divide the x, y, and z coordinates of the position by the w coordinate.
+		position.x /= position.w;
+		position.y /= position.w;
+		position.z /= position.w;
+
+		// Transform the x and y coordinates of the position from normalized device coordinates
+		// to screen space coordinates.
+		position.x = (position.x + 1.f) * m_fWidth * .5f;
+		position.y = (1.f - position.y) * m_fHeight * .5f;
+	}
 }
@@ -1,9 +1,21 @@
 #pragma once
+#include <atomic>
+#include <unordered_map>
+
+#include "Bvh.h"
 #include "DataTypes.h"
+#include "DepthFormat.h"
+#include "Frustum.h"
+#include "OcclusionBuffer.h"
+#include "RadixSort.h"
+#include "ThreadPool.h"
+#include "TriangleSetup.h"
+#include "VertexCompression.h"
 
 namespace dae
 {
 	class Mesh;
+	class StreamingMesh;
 	class Texture;
 	struct Camera;
 	struct Vertex_Out;
@@ -12,7 +24,7 @@ namespace dae
 	{
 	public:
 		explicit SoftwareRasterizer(SDL_Window* pWindow);
-		~SoftwareRasterizer();
+		~SoftwareRasterizer() = default;
 
 		SoftwareRasterizer(const SoftwareRasterizer&) = delete;
 		SoftwareRasterizer(SoftwareRasterizer&&) noexcept = delete;
@@ -22,13 +34,37 @@ namespace dae
 		void Render(const ColorRGB& clearColor);
 		bool SaveBufferToImage() const;
 
-		void SetMeshes(const std::vector<Mesh*>& meshes) { m_pMeshes = meshes; }
+		void SetMeshes(const std::vector<Mesh*>& meshes) { m_pMeshes = meshes; m_IsInstanceBvhValid = false; m_TransformCache.clear(); }
+		void SetStreamingMeshes(const std::vector<StreamingMesh*>& meshes) { m_pStreamingMeshes = meshes; }
 		void SetCullMode(CullMode cullMode) { m_CullMode = cullMode; }
 		void SetCamera(Camera* pCamera) { m_pCamera = pCamera; }
 		void CycleShadingMode();
+		// 1x, 2x, 4x and 8x multisampling, coverage and depth are tested per sample while every pixel is shaded once
+		void CycleSampleCount();
+		// Float, reversed float, 24 bit and 16 bit depth
+		void CycleDepthFormat();
+		// Off, the shading rate of every draw, or that combined with a rate per tile picked from the contrast of the previous frame
+		void CycleShadingRateMode();
 		bool ToggleBoundingBox() { m_RenderBoundingBox = !m_RenderBoundingBox; return m_RenderBoundingBox; }
 		bool ToggleDepthBuffer() { m_RenderDepthBuffer = !m_RenderDepthBuffer; return m_RenderDepthBuffer; }
 		bool ToggleNormalMap() { m_RenderNormalMap = !m_RenderNormalMap; return m_RenderNormalMap; }
+		bool ToggleCompactVertices() { m_UseCompactVertices = !m_UseCompactVertices; return m_UseCompactVertices; }
+		bool ToggleLods() { m_UseLods = !m_UseLods; return m_UseLods; }
+		bool ToggleOcclusionCulling() { m_UseOcclusionCulling = !m_UseOcclusionCulling; return m_UseOcclusionCulling; }
+		// Blends the edges of triangles by the part of the pixel they cover, multisampling takes precedence when both are on
+		bool ToggleEdgeAntiAliasing() { m_UseEdgeAntiAliasing = !m_UseEdgeAntiAliasing; return m_UseEdgeAntiAliasing; }
+		// Renders the triangles of a bin nearest first and keeps the rows they covered, a triangle skips the covered pixels of a row
+		// when it lies behind all of them. Every other pixel is still depth tested, so the image matches the one without it.
+		bool ToggleCoverageBuffer() { m_UseCoverageBuffer = !m_UseCoverageBuffer; return m_UseCoverageBuffer; }
+
+		// Nearest mesh instance under a pixel, found through the instance BVH and tested against the triangles of LOD 0
+		struct InstancePick
+		{
+			const Mesh* pMesh{ nullptr };
+			size_t instance{};
+			float distance{ FLT_MAX };
+		};
+		bool PickInstance(int x, int y, InstancePick& pick);
 
 	private:
 		enum class ShadingMode
@@ -40,6 +76,42 @@ namespace dae
 		};
 		ShadingMode m_ShadingMode{ ShadingMode::Combined };
 
+		enum class ShadingRateMode
+		{
+			Off,
+			PerDraw,
+			Contrast
+		};
+		ShadingRateMode m_ShadingRateMode{ ShadingRateMode::Off };
+
+		// Rate image with one shading rate per tile of 8x8 pixels. Every bin fills its tiles from the contrast of the colors it rendered,
+		// the next frame shades them at that rate. Neighbouring pixels closer in luma than m_MaxCoarseContrast can share a color.
+		static constexpr int m_ShadingRateTileShift{ 3 };
+		static constexpr int m_ShadingRateTileSize{ 1 << m_ShadingRateTileShift };
+		static constexpr int m_MaxCoarseContrast{ 8 };
+		std::vector<ShadingRate> m_ShadingRates{};
+		int m_ShadingRateTilesX{};
+
+		// Vertex attributes interpolated per pixel, only the ones the shading mode reads get a plane
+		enum ShadedAttributes : uint32_t
+		{
+			AttributeNormal = 1 << 0,
+			AttributeTangent = 1 << 1,
+			AttributeUV = 1 << 2,
+			AttributeColor = 1 << 3,
+			AttributeWorldPos = 1 << 4
+		};
+		static constexpr int m_MaxAttributeFloats{ 14 };
+
+		struct AttributePlanes
+		{
+			// Material of the draw the triangle belongs to
+			const Material* pMaterial{ nullptr };
+			uint32_t attributes{};
+			int nrPlanes{};
+			ScreenPlane planes[m_MaxAttributeFloats]{};
+		};
+
 		const LightingData m_LightingData{};
 
 		SDL_Window* m_pWindow{ nullptr };
@@ -51,36 +123,340 @@ namespace dae
 		bool m_RenderBoundingBox{ false };
 		bool m_RenderDepthBuffer{ false };
 		bool m_RenderNormalMap{ true };
+		bool m_UseCompactVertices{ true };
+		bool m_UseLods{ true };
+		bool m_UseOcclusionCulling{ true };
+		bool m_UseEdgeAntiAliasing{ false };
+		bool m_UseCoverageBuffer{ false };
+
+		DepthFormat m_DepthFormat{ DepthFormat::Float };
+
+		// Samples of a pixel lie next to each other in the sample buffers of a bin, the bounding box view skips them
+		int m_SampleCount{ 1 };
+		static constexpr int m_MaxSampleCount{ 8 };
+
+		struct SamplePattern
+		{
+			float x[m_MaxSampleCount];
+			float y[m_MaxSampleCount];
+		};
+
+		bool IsMultisampled() const { return m_SampleCount > 1 && !m_RenderBoundingBox; }
+		bool IsEdgeAntiAliased() const { return m_UseEdgeAntiAliasing && !IsMultisampled() && !m_RenderBoundingBox; }
+		bool IsAntiAliased() const { return IsMultisampled() || IsEdgeAntiAliased(); }
+		bool IsCoverageBuffered() const { return m_UseCoverageBuffer && !IsAntiAliased() && !m_RenderBoundingBox; }
+		const SamplePattern& GetSamplePattern() const;
+
+		// Largest error in pixels a LOD may introduce on screen
+		static constexpr float m_MaxLodPixelError{ 1.f };
+
+		// The nearest instances whose bounding sphere covers at least this fraction of the screen height occlude the others
+		static constexpr size_t m_MaxOccluders{ 16 };
+		static constexpr float m_MinOccluderScreenSize{ .1f };
 
 		float m_AspectRatio{};
 
 		int m_Height{};
 		int m_Width{};
 
-		int m_CurrentMeshIndex{ 0 };
-
 		// Float of the width and height of the window
 		float m_fHeight{};
 		float m_fWidth{};
 
-		float* m_pDepthBufferPixels{};
+		// The screen is split into bins of 64x64 pixels. Draws only record which of their triangles touch which bin,
+		// after the last draw all threads render one bin at a time into buffers small enough to stay in cache,
+		// and every bin is written to the back buffer once.
+		static constexpr int m_BinShift{ 6 };
+		static constexpr int m_BinSize{ 1 << m_BinShift };
+		int m_BinsX{};
+		int m_BinsY{};
+
+		// Depth is stored in blocks of 8x8 pixels, the eight depths of a block row lie next to each other
+		static constexpr int m_DepthBlockShift{ 3 };
+		static constexpr int m_DepthBlockSize{ 1 << m_DepthBlockShift };
 
 		CullMode m_CullMode{ CullMode::Back };
 		Camera* m_pCamera{ nullptr };
 
 		std::vector<Mesh*> m_pMeshes{};
+		std::vector<StreamingMesh*> m_pStreamingMeshes{};
+
+		// Every mesh instance is an item of the BVH, refit when the transform version of its mesh changes
+		struct InstanceItem
+		{
+			const Mesh* pMesh{ nullptr };
+			uint32_t instance{};
+		};
+		std::vector<InstanceItem> m_InstanceItems{};
+		std::vector<Matrix> m_InstanceWorldMatrices{};
+		std::vector<uint32_t> m_MeshFirstItems{};
+		std::vector<uint32_t> m_MeshTransformVersions{};
+		Bvh m_InstanceBvh{};
+		bool m_IsInstanceBvhValid{ false };
+
+		// Instances the BVH could not accept or reject as a whole, their boxes are culled eight at a time
+		struct VisibleInstance
+		{
+			uint32_t item{};
+			int cullIndex{ -1 };
+		};
+		std::vector<VisibleInstance> m_VisibleInstances{};
+		FrustumCuller m_FrustumCuller{};
+		std::vector<uint8_t> m_IsInstanceVisible{};
+
+		// Instances that survived culling, in the order they are drawn
+		std::vector<uint32_t> m_DrawItems{};
+		OcclusionBuffer m_OcclusionBuffer{};
 
-		void ClearDepthBuffer() const;
-		void ClearBackBuffer(const ColorRGB& clearColor) const;
+		// Source vertices, transform and triangles of one instance.
+		// Either the compact vertices or the full vertices are set, and either the 16 or the 32 bit indices.
+		struct DrawCall
+		{
+			const std::vector<Vertex_In>* pVertices{ nullptr };
+			const CompactVertices* pCompactVertices{ nullptr };
+			Matrix worldMatrix{};
+			Matrix viewProjMatrix{};
+
+			const Material* pMaterial{ nullptr };
+			const std::vector<uint16_t>* pIndices16{ nullptr };
+			const std::vector<uint32_t>* pIndices32{ nullptr };
+			PrimitiveTopology topology{ PrimitiveTopology::TriangleList };
+
+			// Instance item the transformed vertices are cached under, streaming clusters come and go and are never cached
+			uint32_t cacheItem{ m_UncachedItem };
+
+			ShadingRate shadingRate{ ShadingRate::Rate1x1 };
+		};
+		static constexpr uint32_t m_UncachedItem{ UINT32_MAX };
 
-		void RenderMesh(const Mesh* pMesh) const;
-		void RenderTriangle(const Vertex_Out& v0, const Vertex_Out& v1, const Vertex_Out& v2) const;
-		ColorRGB PixelShading(const Vertex_Out& v) const;
+		// Transformed vertices of a draw and the triangles that survived culling, kept across frames while they stay valid.
+		// Positions and culling depend on the world matrix, view projection, viewport and cull mode,
+		// the world space attributes only on the world matrix, so a moving camera does not transform them again.
+		struct TransformedDraw
+		{
+			Matrix worldMatrix{};
+			Matrix viewProjMatrix{};
+			float viewportWidth{};
+			float viewportHeight{};
+			CullMode cullMode{ CullMode::Back };
+			bool isAntiAliased{ false };
+			bool isValid{ false };
+
+			std::vector<Vertex_Out> verticesOut{};
+			// Indices of the triangles that survived culling, three per triangle, and a bit for every vertex they use
+			std::vector<uint32_t> triangles{};
+			std::vector<uint64_t> usedVertices{};
+			std::vector<TriangleSetup> setups{};
+			// A bit for every vertex whose attributes are transformed with the current world matrix
+			std::vector<uint64_t> transformedAttributes{};
+
+			uint64_t lastUsedFrame{};
+		};
+
+		struct TransformKey
+		{
+			const void* pVertices{ nullptr };
+			uint32_t item{};
+
+			bool operator==(const TransformKey&) const = default;
+		};
+
+		struct TransformKeyHash
+		{
+			size_t operator()(const TransformKey& key) const
+			{
+				return std::hash<const void*>{}(key.pVertices) ^ std::hash<uint32_t>{}(key.item) * 0x9E3779B97F4A7C15ull;
+			}
+		};
+
+		// Entries not drawn in a frame are dropped at its end, new entries are only added while the cache is within its budget.
+		// A new entry counts with the size it will reach once transformed, the total is recounted from the entries after every frame.
+		std::unordered_map<TransformKey, std::unique_ptr<TransformedDraw>, TransformKeyHash> m_TransformCache{};
+		size_t m_TransformCacheBytes{};
+		uint64_t m_FrameIndex{};
+		static constexpr size_t m_TransformCacheBudget{ 256ull << 20 };
+
+		// Draws that are not cached transform into one of these, the bins point into them until the end of the frame
+		std::vector<std::unique_ptr<TransformedDraw>> m_FrameTransformedDraws{};
+		size_t m_NrFrameTransformedDraws{};
+
+		// The vertices of a draw are transformed by a worker thread, while the render thread bins the draws submitted before it
+		struct DrawSlot
+		{
+			DrawCall draw{};
+			TransformedDraw* pTransformed{ nullptr };
+			std::future<void> transformed{};
+			bool isPending{ false };
+		};
+
+		// Opaque draws of the frame, submitted nearest first so the depth test rejects most hidden pixels before they are shaded.
+		// The nearest depth of every draw is quantized to 16 bits between the nearest and farthest draw and radix sorted.
+		std::vector<DrawCall> m_FrameDraws{};
+		std::vector<float> m_FrameDrawDepths{};
+		std::vector<RadixSort::Entry> m_DrawOrder{};
+		RadixSort m_DrawSorter{};
+
+		static constexpr uint32_t m_DrawSlotsPerThread{ 2 };
+		std::vector<DrawSlot> m_DrawSlots{};
+		size_t m_NextDrawSlot{ 0 };
+
+		struct BinnedDraw
+		{
+			const TransformedDraw* pTransformed{ nullptr };
+			const Material* pMaterial{ nullptr };
+			ShadingRate shadingRate{ ShadingRate::Rate1x1 };
+		};
+
+		struct BinEntry
+		{
+			uint32_t draw{};
+			uint32_t setup{};
+		};
+
+		// Bin entry with the inverse depth of its nearest vertex, the coverage buffer renders them by draw and nearest first within a draw
+		struct SortedEntry
+		{
+			uint32_t entry{};
+			uint32_t draw{};
+			float nearestInverseDepth{};
+		};
+
+		// Triangles touching every bin, in the order they were drawn
+		std::vector<BinnedDraw> m_BinnedDraws{};
+		std::vector<std::vector<BinEntry>> m_Bins{};
+		std::atomic<int> m_NextBin{};
+
+		// Buffers of the bin a thread renders, indexed by the pixels of the bin, colors are packed as 0x00RRGGBB.
+		// Depths are stored in the current depth format, a depth block is only cleared when a triangle first touches it.
+		// Nothing reads depth after the frame, so it never leaves these buffers.
+		struct BinBuffers
+		{
+			Int2 min{};
+			Int2 max{};
+
+			std::vector<uint32_t> colors{};
+			std::vector<std::byte> depths{};
+			std::vector<uint8_t> isDepthBlockCleared{};
+			// Part of every pixel covered by the surfaces drawn into it, only used by edge anti-aliasing
+			std::vector<float> coverages{};
+			// Eight depths are read for the samples of every pixel, the buffer is padded for the last one
+			std::vector<std::byte> sampleDepths{};
+			std::vector<uint32_t> sampleColors{};
+			// Coverage buffer, one bit per pixel of a row is set once a triangle wrote its depth, with the farthest depth written to the row.
+			// Triangles behind that depth only visit the clear bits, the spans they can still fill.
+			std::vector<uint64_t> coveredRows{};
+			std::vector<std::byte> coveredRowDepths{};
+			std::vector<SortedEntry> sortedEntries{};
+			// Color a coarse block was shaded with, indexed by its top left pixel and only valid for the triangle that shaded it.
+			// Triangles are numbered across bins, so nothing needs to be cleared between them.
+			std::vector<ColorRGB> coarseColors{};
+			std::vector<uint32_t> coarseTriangles{};
+			uint32_t triangle{};
+
+			void NextTriangle();
+
+			int GetIndex(int px, int py) const { return (py - min.y) * m_BinSize + px - min.x; }
+			// The eight depths of the block row holding the pixel, px can lie anywhere in the block
+			template <typename Depth>
+			typename Depth::Type* GetDepthRow(int px, int py);
+			template <typename Depth>
+			typename Depth::Type& GetDepth(int px, int py) { return GetDepthRow<Depth>(px, py)[px & (m_DepthBlockSize - 1)]; }
+			template <typename Depth>
+			typename Depth::Type* GetSampleDepths(int px, int py, int sampleCount) { return reinterpret_cast<typename Depth::Type*>(sampleDepths.data()) + static_cast<size_t>(GetIndex(px, py)) * sampleCount; }
+		};
+		// One per worker thread and one for the render thread
+		std::vector<BinBuffers> m_BinBuffers{};
+
+		// Declared after the draws and buffers, so the workers are joined before they are freed
+		ThreadPool m_ThreadPool;
+
+		void SubmitDraw(const DrawCall& draw);
+		TransformedDraw* AcquireTransformedDraw(const DrawCall& draw);
+		bool IsTransformUpToDate(const DrawCall& draw, const TransformedDraw& transformed) const;
+		void TransformDraw(const DrawCall& draw, TransformedDraw& transformed) const;
+		void TrimTransformCache();
+		size_t EstimateTransformedBytes(const DrawCall& draw) const;
+		static size_t GetTransformedBytes(const TransformedDraw& transformed);
+		void BinDraw(DrawSlot& slot);
+		void FlushDraws();
+
+		// Bins no triangle touches get the clear color straight away
+		void RenderBins(const ColorRGB& clearColor);
+		void RenderNextBins(BinBuffers& buffers, const ColorRGB& clearColor);
+		void RenderBin(int bin, BinBuffers& buffers, const ColorRGB& clearColor);
+		// Clears everything but depth, which is cleared in the format the triangles are rendered with
+		void ClearBin(BinBuffers& buffers, const ColorRGB& clearColor) const;
+		void ResolveSamples(BinBuffers& buffers) const;
+		// Edge anti-aliasing keeps colors premultiplied by their coverage, the clear color fills the rest
+		void ResolveCoverage(BinBuffers& buffers, const ColorRGB& clearColor) const;
+		// Streaming stores bypass the cache, the back buffer is only written here
+		void WriteBin(const BinBuffers& buffers) const;
+		void UpdateShadingRates(const BinBuffers& buffers);
+
+		void AddFrameDraw(const DrawCall& draw, const Bvh::Box& box);
+		void SubmitFrameDrawsFrontToBack();
+
+		void UpdateInstanceBvh();
+		Bvh::Box UpdateInstanceItem(uint32_t item);
+
+		void CullOccludedInstances(const Matrix& viewProjMatrix);
+
+		// Radius of the bounding sphere of the mesh on screen in pixels, FLT_MAX when the camera is inside it
+		float GetProjectedRadius(const Mesh* pMesh, const Matrix& worldMatrix) const;
+		int SelectLod(const Mesh* pMesh, const Matrix& worldMatrix, float maxPixelError) const;
+
+		// Rejects the triangles outside the screen or facing away, only the vertices of the remaining ones get their attributes
+		template <typename Index>
+		void CullTriangles(const std::vector<Vertex_Out>& verticesOut, const std::vector<Index>& indices, PrimitiveTopology topology, std::vector<uint32_t>& triangles, std::vector<uint64_t>& usedVertices) const;
+		bool IsTriangleVisible(const Vertex_Out& v0, const Vertex_Out& v1, const Vertex_Out& v2) const;
+
+		// Every path is compiled once per depth format and only visits the pixels of the triangle inside the bin
+		template <typename Depth>
+		void RenderBinTriangles(const std::vector<BinEntry>& entries, BinBuffers& buffers) const;
+		template <typename Depth>
+		void RenderTriangle(const TriangleSetup& setup, const BinnedDraw& draw, BinBuffers& buffers) const;
+		// Triangles of at most four pixels, their pixel centers are tested up front and attributes are only set up when one is covered
+		template <typename Depth>
+		void RenderMicroTriangle(const TriangleSetup& setup, const BinnedDraw& draw, BinBuffers& buffers) const;
+		// Triangles of at least TriangleSetup::m_MinSpanPixels, only the pixels between the edges of each row are visited
+		template <typename Depth>
+		void RenderSpanTriangle(const TriangleSetup& setup, const BinnedDraw& draw, BinBuffers& buffers) const;
+		// Coverage and depth of all samples of a pixel are tested at once, the pixel is shaded once for all of them
+		template <typename Depth>
+		void RenderMultisampledTriangle(const TriangleSetup& setup, const BinnedDraw& draw, BinBuffers& buffers) const;
+		// Coverage buffer paths, a triangle behind every covered pixel of a row only visits the spans of the row still uncovered
+		template <typename Depth>
+		void RenderCoveredBinTriangles(const std::vector<BinEntry>& entries, BinBuffers& buffers) const;
+		template <typename Depth>
+		void RenderCoveredTriangle(const TriangleSetup& setup, const BinnedDraw& draw, BinBuffers& buffers) const;
+		// Pixels of a row covered by the triangle, relative to its box, false when the row has none
+		static bool FindRowSpan(const TriangleSetup& setup, float dy, int& first, int& last);
+		void SetupAttributePlanes(const TriangleSetup& setup, const BinnedDraw& draw, AttributePlanes& attributePlanes) const;
+		ColorRGB ShadePixel(int px, int py, float z, float w, const AttributePlanes& attributePlanes, const float* pValues, float uvLod) const;
+		// Shading rate of the draw, coarsened by the rate image in contrast mode
+		ShadingRate GetShadingRate(const BinnedDraw& draw, int px, int py) const;
+		// Shades the block of the pixel once at its center and hands the color to the other pixels of the block the triangle covers.
+		// Coverage and depth are still tested per pixel by the caller.
+		ColorRGB ShadeCoarsePixel(const TriangleSetup& setup, const AttributePlanes& attributePlanes, BinBuffers& buffers, ShadingRate rate, int px, int py) const;
+		void WritePixel(BinBuffers& buffers, int px, int py, const ColorRGB& color) const;
+		// Surfaces in front cover their part of the pixel, surfaces behind only fill the part that is not covered yet
+		void BlendPixel(BinBuffers& buffers, int px, int py, const ColorRGB& color, float coverage, bool isInFront) const;
+		uint32_t GetShadedAttributes(const Material& material) const;
+		ColorRGB PixelShading(const Material& material, const Vertex_Out& v, const Vector3& viewDirection, float uvLod) const;
+
+		static uint32_t PackColor(const ColorRGB& color);
+		static ColorRGB UnpackColor(uint32_t color);
 
 		static float EdgeFunction(const Vector2& a, const Vector2& b, const Vector2& c);
 
 		bool IsOutsideViewFrustum(const Vertex_Out& v) const;
-		void CalculateBoundingBox(const Vertex_Out& v0, const Vertex_Out& v1, const Vertex_Out& v2, Int2& min, Int2& max) const;
-		void VertexTransformationFunction(const std::vector<Mesh*>& pMeshes) const;
+
+		// Vertices are transformed in two passes, the screen positions of all of them first,
+		// then the remaining attributes of the vertices used by triangles that survived culling
+		void TransformPositions(const std::vector<Vertex_In>& vertices, std::vector<Vertex_Out>& verticesOut, const Matrix& worldMatrix, const Matrix& viewProjMatrix) const;
+		void TransformPositions(const CompactVertices& vertices, std::vector<Vertex_Out>& verticesOut, const Matrix& worldMatrix, const Matrix& viewProjMatrix) const;
+		void TransformAttributes(const std::vector<Vertex_In>& vertices, TransformedDraw& transformed) const;
+		void TransformAttributes(const CompactVertices& vertices, TransformedDraw& transformed) const;
+		void ToScreenSpace(Vector4& position) const;
 	};
 }
@@ -0,0 +1,477 @@
+#include "pch.h"
+#include "StreamingMesh.h"
+
+#include <filesystem>
+#include <map>
+#include <ranges>
+
+#include "MappedFile.h"
+#include "Utils.h"
+
+namespace dae
+{
+	StreamingMesh::StreamingMesh(const std::string& cookedPath, size_t memoryBudget)
+		: m_File{ cookedPath, std::ios::binary },
+		m_MemoryBudget{ memoryBudget }
+	{
+		Header header{};
+		if (!m_File.read(reinterpret_cast<char*>(&header), sizeof(Header)) || header.magic != m_Magic || header.version != m_Version)
+		{
+			std::cout << "StreamingMesh: invalid cooked mesh: " << cookedPath << '\n';
+			return;
+		}
+
+		// Only the cluster table is loaded up front
+		m_Clusters.resize(header.clusterCount);
+		m_File.seekg(static_cast<std::streamoff>(header.tableOffset));
+		if (!m_File.read(reinterpret_cast<char*>(m_Clusters.data()), static_cast<std::streamsize>(m_Clusters.size() * sizeof(ClusterInfo))))
+		{
+			std::cout << "StreamingMesh: invalid cluster table: " << cookedPath << '\n';
+			m_Clusters.clear();
+			return;
+		}
+
+		m_pResidentClusters.resize(m_Clusters.size());
+	}
+
+	bool StreamingMesh::Cook(const std::string& objPath, const std::string& cookedPath, bool flipAxisAndWinding)
+	{
+		std::ifstream file{ objPath };
+		if (!file)
+			return false;
+
+		// Pass 1: stream the vertex attributes to scratch files, they are memory mapped for pass 2
+		// so the operating system pages them in and out instead of keeping them all resident.
+		const std::string positionsPath{ cookedPath + ".positions.tmp" };
+		const std::string uvsPath{ cookedPath + ".uvs.tmp" };
+		const std::string normalsPath{ cookedPath + ".normals.tmp" };
+		{
+			std::ofstream positionsFile{ positionsPath, std::ios::binary | std::ios::trunc };
+			std::ofstream uvsFile{ uvsPath, std::ios::binary | std::ios::trunc };
+			std::ofstream normalsFile{ normalsPath, std::ios::binary | std::ios::trunc };
+
+			std::string sCommand;
+			while (file >> sCommand)
+			{
+				if (sCommand == "v")
+				{
+					Vector3 position{};
+					file >> position.x >> position.y >> position.z;
+					positionsFile.write(reinterpret_cast<const char*>(&position), sizeof(Vector3));
+				}
+				else if (sCommand == "vt")
+				{
+					Vector2 uv{};
+					file >> uv.x >> uv.y;
+					uv.y = 1 - uv.y;
+					uvsFile.write(reinterpret_cast<const char*>(&uv), sizeof(Vector2));
+				}
+				else if (sCommand == "vn")
+				{
+					Vector3 normal{};
+					file >> normal.x >> normal.y >> normal.z;
+					normalsFile.write(reinterpret_cast<const char*>(&normal), sizeof(Vector3));
+				}
+				//read till end of line and ignore all remaining chars
+				file.ignore(1000, '\n');
+			}
+		}
+
+		MappedFile positionsView{};
+		MappedFile uvsView{};
+		MappedFile normalsView{};
+		positionsView.Open(positionsPath);
+		uvsView.Open(uvsPath);
+		normalsView.Open(normalsPath);
+
+		const Attributes attributes
+		{
+			reinterpret_cast<const Vector3*>(positionsView.GetData()), positionsView.GetSize() / sizeof(Vector3),
+			reinterpret_cast<const Vector2*>(uvsView.GetData()), uvsView.GetSize() / sizeof(Vector2),
+			reinterpret_cast<const Vector3*>(normalsView.GetData()), normalsView.GetSize() / sizeof(Vector3)
+		};
+
+		// Pass 2: read the faces chunk by chunk and write every chunk out as clusters
+		std::ofstream cookedFile{ cookedPath, std::ios::binary | std::ios::trunc };
+		Header header{ m_Magic, m_Version };
+		cookedFile.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+
+		std::vector<ClusterInfo> clusters{};
+		std::vector<Face> chunk{};
+		chunk.reserve(m_ChunkSize);
+
+		bool isValid{ attributes.nrPositions > 0 };
+
+		file.clear();
+		file.seekg(0);
+		std::string sCommand;
+		while (isValid && file >> sCommand)
+		{
+			if (sCommand == "f")
+			{
+				Face face{};
+				for (FaceVertex& faceVertex : face.vertices)
+				{
+					// OBJ format uses 1-based arrays, 0 marks a missing attribute
+					file >> faceVertex.position;
+					if ('/' == file.peek())
+					{
+						file.ignore();
+						if ('/' != file.peek())
+						{
+							file >> faceVertex.uv;
+						}
+						if ('/' == file.peek())
+						{
+							file.ignore();
+							file >> faceVertex.normal;
+						}
+					}
+
+					isValid &= faceVertex.position >= 1 && faceVertex.position <= attributes.nrPositions
+						&& faceVertex.uv <= attributes.nrUVs && faceVertex.normal <= attributes.nrNormals;
+				}
+
+				chunk.emplace_back(face);
+				if (chunk.size() == m_ChunkSize)
+				{
+					WriteChunk(chunk, attributes, flipAxisAndWinding, cookedFile, clusters);
+					chunk.clear();
+				}
+			}
+			//read till end of line and ignore all remaining chars
+			file.ignore(1000, '\n');
+		}
+
+		if (isValid)
+		{
+			WriteChunk(chunk, attributes, flipAxisAndWinding, cookedFile, clusters);
+
+			// Cluster table at the end, then patch the header now that its location is known
+			header.clusterCount = static_cast<uint32_t>(clusters.size());
+			header.tableOffset = static_cast<uint64_t>(cookedFile.tellp());
+			cookedFile.write(reinterpret_cast<const char*>(clusters.data()), static_cast<std::streamsize>(clusters.size() * sizeof(ClusterInfo)));
+			cookedFile.seekp(0);
+			cookedFile.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+		}
+		cookedFile.close();
+
+		positionsView.Close();
+		uvsView.Close();
+		normalsView.Close();
+
+		std::error_code error{};
+		std::filesystem::remove(positionsPath, error);
+		std::filesystem::remove(uvsPath, error);
+		std::filesystem::remove(normalsPath, error);
+
+		if (!isValid || clusters.empty())
+		{
+			std::cout << "StreamingMesh: failed to cook " << objPath << '\n';
+			std::filesystem::remove(cookedPath, error);
+			return false;
+		}
+
+		return true;
+	}
+
+	std::string StreamingMesh::GetCookedPath(const std::string& objPath)
+	{
+		return "Resources/Cache/" + std::filesystem::path{ objPath }.stem().string() + ".dmesh";
+	}
+
+	void StreamingMesh::UpdateResidency(const Matrix& viewProj, const Vector3& cameraPosition)
+	{
+		++m_FrameIndex;
+		m_pVisibleClusters.clear();
+
+		if (!IsValid()) return;
+
+		const Matrix worldViewProj{ m_WorldMatrix * viewProj };
+
+		// Gather the visible clusters, sorted front to back
+		std::vector<std::pair<float, size_t>> visibleClusters{};
+		for (size_t i{ 0 }; i < m_Clusters.size(); ++i)
+		{
+			const ClusterInfo& cluster{ m_Clusters[i] };
+			if (!IsClusterVisible(cluster, worldViewProj)) continue;
+
+			const Vector3 center{ m_WorldMatrix.TransformPoint((cluster.boundsMin + cluster.boundsMax) * .5f) };
+			visibleClusters.emplace_back((center - cameraPosition).SqrMagnitude(), i);
+		}
+		std::ranges::sort(visibleClusters);
+
+		// Visible clusters that are already resident are never evicted for the ones still missing
+		for (const size_t clusterIndex : visibleClusters | std::views::values)
+		{
+			if (m_pResidentClusters[clusterIndex])
+			{
+				m_pResidentClusters[clusterIndex]->lastUsedFrame = m_FrameIndex;
+			}
+		}
+
+		int nrLoads{ 0 };
+		bool canLoad{ true };
+		for (const size_t clusterIndex : visibleClusters | std::views::values)
+		{
+			if (!m_pResidentClusters[clusterIndex])
+			{
+				// Loading stops once this frame's loads are used up or the budget is filled with visible clusters,
+				// farther clusters that are resident already are still drawn
+				if (!canLoad) continue;
+				if (nrLoads == m_MaxLoadsPerFrame || !LoadCluster(clusterIndex))
+				{
+					canLoad = false;
+					continue;
+				}
+				++nrLoads;
+			}
+
+			ResidentCluster* pCluster{ m_pResidentClusters[clusterIndex].get() };
+			pCluster->lastUsedFrame = m_FrameIndex;
+			m_pVisibleClusters.emplace_back(pCluster);
+		}
+	}
+
+	bool StreamingMesh::IsClusterVisible(const ClusterInfo& cluster, const Matrix& worldViewProj) const
+	{
+		// The cluster is culled when all corners of its bounds are outside the same clip plane
+		uint32_t outsideAll{ 0b111111 };
+		for (int corner{ 0 }; corner < 8; ++corner)
+		{
+			const Vector3 point
+			{
+				corner & 1 ? cluster.boundsMax.x : cluster.boundsMin.x,
+				corner & 2 ? cluster.boundsMax.y : cluster.boundsMin.y,
+				corner & 4 ? cluster.boundsMax.z : cluster.boundsMin.z
+			};
+			const Vector4 clip{ worldViewProj.TransformPoint(Vector4{ point, 1.f }) };
+
+			uint32_t outside{ 0 };
+			outside |= (clip.x < -clip.w) << 0;
+			outside |= (clip.x > clip.w) << 1;
+			outside |= (clip.y < -clip.w) << 2;
+			outside |= (clip.y > clip.w) << 3;
+			outside |= (clip.z < .0f) << 4;
+			outside |= (clip.z > clip.w) << 5;
+
+			outsideAll &= outside;
+		}
+
+		return outsideAll == 0;
+	}
+
+	bool StreamingMesh::LoadCluster(size_t clusterIndex)
+	{
+		const ClusterInfo& cluster{ m_Clusters[clusterIndex] };
+
+		const size_t sizeInBytes
+		{
+			cluster.vertexCount * sizeof(Vertex_In) +
+			cluster.indexCount * sizeof(uint32_t)
+		};
+
+		while (m_ResidentBytes + sizeInBytes > m_MemoryBudget)
+		{
+			if (!EvictLeastRecentlyUsed()) return false;
+		}
+
+		auto pCluster{ std::make_unique<ResidentCluster>() };
+		pCluster->vertices.resize(cluster.vertexCount);
+		pCluster->indices.resize(cluster.indexCount);
+		pCluster->boundsMin = cluster.boundsMin;
+		pCluster->boundsMax = cluster.boundsMax;
+		pCluster->sizeInBytes = sizeInBytes;
+
+		m_File.clear();
+		m_File.seekg(static_cast<std::streamoff>(cluster.offset));
+		m_File.read(reinterpret_cast<char*>(pCluster->vertices.data()), static_cast<std::streamsize>(cluster.vertexCount * sizeof(Vertex_In)));
+		m_File.read(reinterpret_cast<char*>(pCluster->indices.data()), static_cast<std::streamsize>(cluster.indexCount * sizeof(uint32_t)));
+		if (!m_File)
+		{
+			std::cout << "StreamingMesh: failed to read cluster " << clusterIndex << '\n';
+			return false;
+		}
+
+		m_ResidentBytes += sizeInBytes;
+		m_pResidentClusters[clusterIndex] = std::move(pCluster);
+		return true;
+	}
+
+	bool StreamingMesh::EvictLeastRecentlyUsed()
+	{
+		// Clusters used this frame are never evicted
+		std::unique_ptr<ResidentCluster>* pOldest{ nullptr };
+		for (std::unique_ptr<ResidentCluster>& pCluster : m_pResidentClusters)
+		{
+			if (!pCluster || pCluster->lastUsedFrame == m_FrameIndex) continue;
+
+			if (!pOldest || pCluster->lastUsedFrame < (*pOldest)->lastUsedFrame)
+			{
+				pOldest = &pCluster;
+			}
+		}
+
+		if (!pOldest) return false;
+
+		m_ResidentBytes -= (*pOldest)->sizeInBytes;
+		pOldest->reset();
+		return true;
+	}
+
+	void StreamingMesh::WriteChunk(std::vector<Face>& chunk, const Attributes& attributes, bool flipAxisAndWinding, std::ofstream& file, std::vector<ClusterInfo>& clusters)
+	{
+		if (chunk.empty()) return;
+
+		// Vertices shared by triangles of the chunk are stored once
+		std::vector<Vertex_In> vertices{};
+		std::vector<uint32_t> indices{};
+		indices.reserve(chunk.size() * 3);
+
+		std::map<std::array<uint32_t, 3>, uint32_t> vertexLookup{};
+		const auto getVertex{ [&](const FaceVertex& faceVertex)
+			{
+				const std::array<uint32_t, 3> key{ faceVertex.position, faceVertex.uv, faceVertex.normal };
+				const auto it{ vertexLookup.find(key) };
+				if (it != vertexLookup.end())
+					return it->second;
+
+				Vertex_In vertex{};
+				vertex.pos = attributes.pPositions[faceVertex.position - 1];
+				if (faceVertex.uv) vertex.uv = attributes.pUVs[faceVertex.uv - 1];
+				if (faceVertex.normal) vertex.norm = attributes.pNormals[faceVertex.normal - 1];
+
+				vertices.emplace_back(vertex);
+				const uint32_t index{ static_cast<uint32_t>(vertices.size()) - 1 };
+				vertexLookup[key] = index;
+				return index;
+			} };
+
+		for (const Face& face : chunk)
+		{
+			const uint32_t index0{ getVertex(face.vertices[0]) };
+			const uint32_t index1{ getVertex(face.vertices[1]) };
+			const uint32_t index2{ getVertex(face.vertices[2]) };
+
+			indices.emplace_back(index0);
+			indices.emplace_back(flipAxisAndWinding ? index2 : index1);
+			indices.emplace_back(flipAxisAndWinding ? index1 : index2);
+		}
+
+		// Same conventions as Utils::ParseOBJ. The tangents are summed over every triangle of the chunk before it is split,
+		// so a vertex on the border of two clusters gets the same tangent in both of them.
+		Utils::CalculateTangents(vertices, indices);
+
+		// Sort the triangles of the chunk along a Morton curve of their centroids,
+		// so consecutive runs of triangles form compact clusters.
+		std::vector<Vector3> centroids(chunk.size());
+		Vector3 chunkMin{ FLT_MAX, FLT_MAX, FLT_MAX };
+		Vector3 chunkMax{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		for (size_t i{ 0 }; i < chunk.size(); ++i)
+		{
+			const Vector3& p0{ vertices[indices[i * 3]].pos };
+			const Vector3& p1{ vertices[indices[i * 3 + 1]].pos };
+			const Vector3& p2{ vertices[indices[i * 3 + 2]].pos };
+			centroids[i] = (p0 + p1 + p2) / 3.f;
+
+			for (int axis{ 0 }; axis < 3; ++axis)
+			{
+				chunkMin[axis] = std::min(chunkMin[axis], centroids[i][axis]);
+				chunkMax[axis] = std::max(chunkMax[axis], centroids[i][axis]);
+			}
+		}
+
+		std::vector<std::pair<uint32_t, uint32_t>> sortedFaces(chunk.size());
+		for (size_t i{ 0 }; i < chunk.size(); ++i)
+		{
+			sortedFaces[i] = { MortonCode(centroids[i], chunkMin, chunkMax), static_cast<uint32_t>(i) };
+		}
+		std::ranges::sort(sortedFaces);
+
+		std::vector<uint32_t> sortedIndices{};
+		sortedIndices.reserve(indices.size());
+		for (const uint32_t faceIndex : sortedFaces | std::views::values)
+		{
+			sortedIndices.insert(sortedIndices.end(), indices.begin() + faceIndex * 3, indices.begin() + faceIndex * 3 + 3);
+		}
+
+		for (size_t first{ 0 }; first < chunk.size(); first += m_ClusterSize)
+		{
+			const size_t nrFaces{ std::min(m_ClusterSize, chunk.size() - first) };
+			WriteCluster(sortedIndices.data() + first * 3, nrFaces, vertices, flipAxisAndWinding, file, clusters);
+		}
+	}
+
+	void StreamingMesh::WriteCluster(const uint32_t* pChunkIndices, size_t nrFaces, const std::vector<Vertex_In>& chunkVertices, bool flipAxisAndWinding, std::ofstream& file, std::vector<ClusterInfo>& clusters)
+	{
+		std::vector<Vertex_In> vertices{};
+		std::vector<uint32_t> indices{};
+		indices.reserve(nrFaces * 3);
+
+		// Only the vertices of the chunk the cluster uses are copied, once each
+		std::map<uint32_t, uint32_t> vertexLookup{};
+		for (size_t i{ 0 }; i < nrFaces * 3; ++i)
+		{
+			const auto [it, isInserted]{ vertexLookup.try_emplace(pChunkIndices[i], static_cast<uint32_t>(vertices.size())) };
+			if (isInserted) vertices.emplace_back(chunkVertices[pChunkIndices[i]]);
+			indices.emplace_back(it->second);
+		}
+
+		ClusterInfo cluster{};
+		cluster.vertexCount = static_cast<uint32_t>(vertices.size());
+		cluster.indexCount = static_cast<uint32_t>(indices.size());
+		cluster.boundsMin = { FLT_MAX, FLT_MAX, FLT_MAX };
+		cluster.boundsMax = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+		for (Vertex_In& vertex : vertices)
+		{
+			if (flipAxisAndWinding)
+			{
+				vertex.pos.z *= -1.f;
+				vertex.norm.z *= -1.f;
+				vertex.tan.z *= -1.f;
+			}
+
+			for (int axis{ 0 }; axis < 3; ++axis)
+			{
+				cluster.boundsMin[axis] = std::min(cluster.boundsMin[axis], vertex.pos[axis]);
+				cluster.boundsMax[axis] = std::max(cluster.boundsMax[axis], vertex.pos[axis]);
+			}
+		}
+
+		// Start every cluster on a new page
+		const uint64_t position{ static_cast<uint64_t>(file.tellp()) };
+		const uint64_t alignedPosition{ (position + m_PageSize - 1) / m_PageSize * m_PageSize };
+		const std::vector<char> padding(alignedPosition - position, 0);
+		file.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+
+		cluster.offset = alignedPosition;
+		file.write(reinterpret_cast<const char*>(vertices.data()), static_cast<std::streamsize>(vertices.size() * sizeof(Vertex_In)));
+		file.write(reinterpret_cast<const char*>(indices.data()), static_cast<std::streamsize>(indices.size() * sizeof(uint32_t)));
+
+		clusters.emplace_back(cluster);
+	}
+
+	uint32_t StreamingMesh::MortonCode(const Vector3& point, const Vector3& boundsMin, const Vector3& boundsMax)
+	{
+		// Interleave 10 bits per axis
+		const auto expandBits{ [](uint32_t v)
+			{
+				v = (v * 0x00010001u) & 0xFF0000FFu;
+				v = (v * 0x00000101u) & 0x0F00F00Fu;
+				v = (v * 0x00000011u) & 0xC30C30C3u;
+				v = (v * 0x00000005u) & 0x49249249u;
+				return v;
+			} };
+
+		uint32_t code{ 0 };
+		for (int axis{ 0 }; axis < 3; ++axis)
+		{
+			const float extent{ boundsMax[axis] - boundsMin[axis] };
+			const float normalized{ extent > .0f ? (point[axis] - boundsMin[axis]) / extent : .0f };
+			code |= expandBits(static_cast<uint32_t>(Saturate(normalized) * 1023.f)) << (2 - axis);
+		}
+
+		return code;
+	}
+}
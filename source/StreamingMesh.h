@@ -0,0 +1,131 @@
+#pragma once
+#include <fstream>
+
+#include "DataTypes.h"
+
+namespace dae
+{
+	// Mesh that lives on disk as a set of spatially coherent clusters.
+	// Only the clusters inside the view frustum are kept in memory, within a fixed memory budget.
+	class StreamingMesh final
+	{
+	public:
+		struct ResidentCluster
+		{
+			std::vector<Vertex_In> vertices{};
+			std::vector<uint32_t> indices{};
+
+			// Object space bounds, used to order the clusters by depth
+			Vector3 boundsMin{};
+			Vector3 boundsMax{};
+
+			size_t sizeInBytes{};
+			uint64_t lastUsedFrame{};
+		};
+
+		explicit StreamingMesh(const std::string& cookedPath, size_t memoryBudget);
+		~StreamingMesh() = default;
+
+		StreamingMesh(const StreamingMesh&) = delete;
+		StreamingMesh(StreamingMesh&&) noexcept = delete;
+		StreamingMesh& operator=(const StreamingMesh&) = delete;
+		StreamingMesh& operator=(StreamingMesh&&) noexcept = delete;
+
+		// Converts an OBJ into the clustered on-disk format, chunk by chunk.
+		// Peak memory is bounded by the chunk size, not by the size of the model.
+		static bool Cook(const std::string& objPath, const std::string& cookedPath, bool flipAxisAndWinding = true);
+		static std::string GetCookedPath(const std::string& objPath);
+
+		// Loads the visible clusters closest to the camera first and evicts the least recently used ones
+		void UpdateResidency(const Matrix& viewProj, const Vector3& cameraPosition);
+
+		bool IsValid() const { return !m_Clusters.empty(); }
+
+		// Getters
+		const std::vector<ResidentCluster*>& GetVisibleClusters() const { return m_pVisibleClusters; }
+		const Matrix& GetWorldMatrix() const { return m_WorldMatrix; }
+		const Material& GetMaterial() const { return m_Material; }
+		size_t GetResidentBytes() const { return m_ResidentBytes; }
+
+		// Setters
+		void SetPosition(const Vector3& position) { m_WorldMatrix = Matrix::CreateTranslation(position); }
+		void RotateY(const float degrees) { m_WorldMatrix = Matrix::CreateRotationY(degrees * TO_RADIANS) * m_WorldMatrix; }
+		void SetMaterial(const Material& material) { m_Material = material; }
+
+	private:
+		// On-disk layout: [Header][cluster 0][cluster 1]...[cluster N-1][ClusterInfo * N]
+		// Every cluster starts on a page boundary and holds its vertices followed by its indices.
+		struct Header
+		{
+			uint32_t magic{};
+			uint32_t version{};
+			uint32_t clusterCount{};
+			uint32_t reserved{};
+			uint64_t tableOffset{};
+		};
+
+		struct ClusterInfo
+		{
+			uint64_t offset{};
+			uint32_t vertexCount{};
+			uint32_t indexCount{};
+			Vector3 boundsMin{};
+			Vector3 boundsMax{};
+		};
+
+		// Vertex of a face as referenced in the OBJ, 0 marks a missing attribute
+		struct FaceVertex
+		{
+			uint32_t position{};
+			uint32_t uv{};
+			uint32_t normal{};
+		};
+
+		struct Face
+		{
+			FaceVertex vertices[3]{};
+		};
+
+		// Memory mapped attribute arrays used while cooking
+		struct Attributes
+		{
+			const Vector3* pPositions{};
+			size_t nrPositions{};
+			const Vector2* pUVs{};
+			size_t nrUVs{};
+			const Vector3* pNormals{};
+			size_t nrNormals{};
+		};
+
+		static constexpr uint32_t m_Magic{ 0x48534D44 }; // "DMSH"
+		static constexpr uint32_t m_Version{ 2 };
+		static constexpr size_t m_PageSize{ 4096 };
+
+		// Triangles parsed before they are sorted and split into clusters
+		static constexpr size_t m_ChunkSize{ 1 << 16 };
+		static constexpr size_t m_ClusterSize{ 1024 };
+
+		// Limits the disk reads per frame, the remaining clusters are loaded on the next frames
+		static constexpr int m_MaxLoadsPerFrame{ 16 };
+
+		std::ifstream m_File{};
+		std::vector<ClusterInfo> m_Clusters{};
+		std::vector<std::unique_ptr<ResidentCluster>> m_pResidentClusters{};
+		std::vector<ResidentCluster*> m_pVisibleClusters{};
+
+		size_t m_MemoryBudget{};
+		size_t m_ResidentBytes{};
+		uint64_t m_FrameIndex{};
+
+		Matrix m_WorldMatrix{};
+		Material m_Material{};
+
+		bool IsClusterVisible(const ClusterInfo& cluster, const Matrix& worldViewProj) const;
+		bool LoadCluster(size_t clusterIndex);
+		bool EvictLeastRecentlyUsed();
+
+		static void WriteChunk(std::vector<Face>& chunk, const Attributes& attributes, bool flipAxisAndWinding, std::ofstream& file, std::vector<ClusterInfo>& clusters);
+		static void WriteCluster(const uint32_t* pChunkIndices, size_t nrFaces, const std::vector<Vertex_In>& chunkVertices, bool flipAxisAndWinding, std::ofstream& file, std::vector<ClusterInfo>& clusters);
+		static uint32_t MortonCode(const Vector3& point, const Vector3& boundsMin, const Vector3& boundsMax);
+	};
+}
@@ -1,32 +1,43 @@
 #include "pch.h"
 #include "Texture.h"
 
+#include "TextureCache.h"
+
 namespace dae
 {
-	Texture::Texture(ID3D11Device* pDevice, SDL_Surface* pSurface)
-		: m_pSurface{ pSurface },
-		m_pSurfacePixels{ static_cast<uint32_t*>(m_pSurface->pixels) }
+	Texture::Texture(ID3D11Device* pDevice, std::unique_ptr<CookedTexture> pCookedTexture)
+		: m_pCookedTexture{ std::move(pCookedTexture) }
 	{
+		const int mipCount{ m_pCookedTexture->GetMipCount() };
+
+		// Log2 of the texel footprint of the whole texture, used to convert uv derivatives to a mip level
+		m_Log2Size = .5f * std::log2(static_cast<float>(m_pCookedTexture->GetWidth()) * static_cast<float>(m_pCookedTexture->GetHeight()));
+
 		DXGI_FORMAT format{ DXGI_FORMAT_R8G8B8A8_UNORM };
 		D3D11_TEXTURE2D_DESC desc{};
-		desc.Width = pSurface->w;
-		desc.Height = pSurface->h;
-		desc.MipLevels = 1;
+		desc.Width = m_pCookedTexture->GetWidth();
+		desc.Height = m_pCookedTexture->GetHeight();
+		desc.MipLevels = mipCount;
 		desc.ArraySize = 1;
 		desc.Format = format;
 		desc.SampleDesc.Count = 1;
 		desc.SampleDesc.Quality = 0;
-		desc.Usage = D3D11_USAGE_DEFAULT;
-		desc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET;
+		desc.Usage = D3D11_USAGE_IMMUTABLE;
+		desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
 		desc.CPUAccessFlags = 0;
-		desc.MiscFlags = D3D11_RESOURCE_MISC_GENERATE_MIPS;
+		desc.MiscFlags = 0;
 
-		D3D11_SUBRESOURCE_DATA initData;
-		initData.pSysMem = pSurface->pixels;
-		initData.SysMemPitch = static_cast<UINT>(pSurface->pitch);
-		initData.SysMemSlicePitch = static_cast<UINT>(pSurface->h * pSurface->pitch);
+		// The cooked texture already contains every mip level, upload them all at once
+		std::vector<D3D11_SUBRESOURCE_DATA> initData(mipCount);
+		for (int level{ 0 }; level < mipCount; ++level)
+		{
+			const CookedTexture::MipLevel& mip{ m_pCookedTexture->GetMip(level) };
+			initData[level].pSysMem = mip.pTexels;
+			initData[level].SysMemPitch = static_cast<UINT>(mip.width * sizeof(uint32_t));
+			initData[level].SysMemSlicePitch = static_cast<UINT>(mip.width * mip.height * sizeof(uint32_t));
+		}
 
-		HRESULT hr{ pDevice->CreateTexture2D(&desc, &initData, &m_pResource) };
+		HRESULT hr{ pDevice->CreateTexture2D(&desc, initData.data(), &m_pResource) };
 		if (FAILED(hr))
 		{
 			std::cout << "Texture::LoadFromFile() failed: " << std::hex << hr << '\n';
@@ -35,7 +46,7 @@ namespace dae
 		D3D11_SHADER_RESOURCE_VIEW_DESC SRVDesc{};
 		SRVDesc.Format = format;
 		SRVDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-		SRVDesc.Texture2D.MipLevels = 1;
+		SRVDesc.Texture2D.MipLevels = mipCount;
 
 		hr = pDevice->CreateShaderResourceView(m_pResource, &SRVDesc, &m_pShaderResourceView);
 		if (FAILED(hr))
@@ -57,33 +68,55 @@ namespace dae
 			m_pResource->Release();
 			m_pResource = nullptr;
 		}
+	}
 
-		if (m_pSurface)
+	Texture* Texture::LoadFromFile(ID3D11Device* pDevice, const std::string& path)
+	{
+		std::unique_ptr<CookedTexture> pCookedTexture{ TextureCache::Load(path) };
+		if (!pCookedTexture)
 		{
-			SDL_FreeSurface(m_pSurface);
-			m_pSurface = nullptr;
+			std::cout << "Failed to load texture from file: " << path << "\n";
+			return nullptr;
 		}
+
+		return new Texture{ pDevice, std::move(pCookedTexture) };
 	}
 
-	Texture* Texture::LoadFromFile(ID3D11Device* pDevice, const std::string& path)
+	Texture* Texture::LoadFromMemory(ID3D11Device* pDevice, std::span<const uint8_t> data, const std::string& name)
 	{
-		SDL_Surface* pSurface{ IMG_Load(path.c_str()) };
-		if (!pSurface)
+		std::unique_ptr<CookedTexture> pCookedTexture{ TextureCache::Load(data) };
+		if (!pCookedTexture)
 		{
-			std::cout << "Failed to load texture from file: " << path << "\n";
+			std::cout << "Failed to load texture from memory: " << name << "\n";
 			return nullptr;
 		}
 
-		return new Texture{ pDevice, pSurface };
+		return new Texture{ pDevice, std::move(pCookedTexture) };
 	}
 
 	ColorRGB Texture::Sample(const Vector2& uv) const
 	{
-		const int x{ static_cast<int>(uv.x * m_pSurface->w) };
-		const int y{ static_cast<int>(uv.y * m_pSurface->h) };
+		return SampleMip(uv, 0);
+	}
+
+	ColorRGB Texture::Sample(const Vector2& uv, float uvLod) const
+	{
+		// Round to the nearest mip level
+		const int maxLevel{ m_pCookedTexture->GetMipCount() - 1 };
+		const int level{ Clamp(static_cast<int>(uvLod + m_Log2Size + .5f), 0, maxLevel) };
+
+		return SampleMip(uv, level);
+	}
+
+	ColorRGB Texture::SampleMip(const Vector2& uv, int level) const
+	{
+		const CookedTexture::MipLevel& mip{ m_pCookedTexture->GetMip(level) };
+
+		const int x{ static_cast<int>(uv.x * mip.width) };
+		const int y{ static_cast<int>(uv.y * mip.height) };
 
 		// Use bitwise operations to extract the individual color channels
-		const uint32_t color{ m_pSurfacePixels[y * m_pSurface->w + x] };
+		const uint32_t color{ mip.pTexels[y * mip.width + x] };
 		const uint8_t red{ color & 0xFF };
 		const uint8_t green{ (color >> 8) & 0xFF };
 		const uint8_t blue{ (color >> 16) & 0xFF };
@@ -1,24 +1,33 @@
 #pragma once
+#include <span>
 
 namespace dae
 {
+	class CookedTexture;
+
 	class Texture final
 	{
 	public:
 		~Texture();
 
 		static Texture* LoadFromFile(ID3D11Device* pDevice, const std::string& path);
+		// Loads an encoded image (PNG, ...) that is already in memory, name is only used for error messages
+		static Texture* LoadFromMemory(ID3D11Device* pDevice, std::span<const uint8_t> data, const std::string& name);
 		ColorRGB Sample(const Vector2& uv) const;
+		// uvLod is the log2 of the uv footprint of a pixel, the size of the texture is added to pick the mip level
+		ColorRGB Sample(const Vector2& uv, float uvLod) const;
 
 		// Getters
 		ID3D11ShaderResourceView* GetSRV() const { return m_pShaderResourceView; }
 
 	private:
-		explicit Texture(ID3D11Device* pDevice, SDL_Surface* pSurface);
-		ID3D11Texture2D* m_pResource;
-		ID3D11ShaderResourceView* m_pShaderResourceView;
+		explicit Texture(ID3D11Device* pDevice, std::unique_ptr<CookedTexture> pCookedTexture);
+		ID3D11Texture2D* m_pResource{ nullptr };
+		ID3D11ShaderResourceView* m_pShaderResourceView{ nullptr };
+
+		std::unique_ptr<CookedTexture> m_pCookedTexture{};
+		float m_Log2Size{};
 
-		SDL_Surface* m_pSurface{ nullptr };
-		uint32_t* m_pSurfacePixels{ nullptr };
+		ColorRGB SampleMip(const Vector2& uv, int level) const;
 	};
 }
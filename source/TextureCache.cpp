@@ -0,0 +1,242 @@
+#include "pch.h"
+#include "TextureCache.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <thread>
+
+namespace dae
+{
+	std::unique_ptr<CookedTexture> TextureCache::Load(const std::string& path)
+	{
+		// Only the raw bytes are read to compute the key, decoding is skipped when the cooked file exists
+		std::ifstream file{ path, std::ios::binary };
+		if (!file)
+			return nullptr;
+
+		const std::vector<uint8_t> source{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+		return Load(source);
+	}
+
+	std::unique_ptr<CookedTexture> TextureCache::Load(std::span<const uint8_t> source)
+	{
+		if (source.empty())
+			return nullptr;
+
+		const uint64_t hash{ HashBytes(source) };
+		const std::string cachePath{ GetCachePath(hash) };
+
+		auto pTexture{ std::make_unique<CookedTexture>() };
+		if (MapCookedFile(cachePath, hash, *pTexture))
+			return pTexture;
+
+		// Cache miss: decode the image and build the mip chain
+		std::vector<uint32_t> texels{};
+		std::vector<Int2> mipSizes{};
+		if (!Cook(source, texels, mipSizes))
+			return nullptr;
+
+		const Header header
+		{
+			m_Magic,
+			m_Version,
+			hash,
+			static_cast<uint32_t>(mipSizes.front().x),
+			static_cast<uint32_t>(mipSizes.front().y),
+			static_cast<uint32_t>(mipSizes.size()),
+			0
+		};
+
+		std::error_code error{};
+		std::filesystem::create_directories(m_CacheDirectory, error);
+
+		// Written under a name of its own and renamed into place, so a load of the same source on another thread never maps a partial file
+		std::stringstream tempPath{};
+		tempPath << cachePath << '.' << std::this_thread::get_id() << ".tmp";
+		{
+			std::ofstream cookedFile{ tempPath.str(), std::ios::binary | std::ios::trunc };
+			cookedFile.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+			cookedFile.write(reinterpret_cast<const char*>(texels.data()), static_cast<std::streamsize>(texels.size() * sizeof(uint32_t)));
+		}
+
+		// Fails when another load already put the file in place and mapped it, that file holds the same texels
+		std::filesystem::rename(tempPath.str(), cachePath, error);
+		if (error) std::filesystem::remove(tempPath.str(), error);
+
+		if (MapCookedFile(cachePath, hash, *pTexture))
+			return pTexture;
+
+		// The cache could not be written, keep the cooked texels in memory instead
+		std::cout << "TextureCache: failed to write cooked texture: " << cachePath << '\n';
+
+		pTexture->m_Texels = std::move(texels);
+
+		size_t offset{ 0 };
+		for (const Int2& size : mipSizes)
+		{
+			pTexture->m_Mips.emplace_back(CookedTexture::MipLevel{ size.x, size.y, pTexture->m_Texels.data() + offset });
+			offset += static_cast<size_t>(size.x) * size.y;
+		}
+
+		return pTexture;
+	}
+
+	uint64_t TextureCache::HashBytes(std::span<const uint8_t> bytes)
+	{
+		// 64-bit FNV-1a
+		uint64_t hash{ 14695981039346656037ull };
+		for (const uint8_t byte : bytes)
+		{
+			hash ^= byte;
+			hash *= 1099511628211ull;
+		}
+
+		return hash;
+	}
+
+	std::string TextureCache::GetCachePath(uint64_t hash)
+	{
+		std::stringstream ss;
+		ss << m_CacheDirectory << std::hex << std::setw(16) << std::setfill('0') << hash << ".dtex";
+		return ss.str();
+	}
+
+	bool TextureCache::MapCookedFile(const std::string& cachePath, uint64_t hash, CookedTexture& texture)
+	{
+		if (!texture.m_File.Open(cachePath))
+			return false;
+
+		const uint8_t* pData{ texture.m_File.GetData() };
+		const size_t fileSize{ texture.m_File.GetSize() };
+
+		Header header{};
+		if (fileSize < sizeof(Header))
+		{
+			texture.m_File.Close();
+			return false;
+		}
+		std::memcpy(&header, pData, sizeof(Header));
+
+		if (header.magic != m_Magic || header.version != m_Version || header.sourceHash != hash || header.mipCount == 0)
+		{
+			texture.m_File.Close();
+			return false;
+		}
+
+		// Walk the mip chain and make sure the file actually contains all of it
+		texture.m_Mips.clear();
+
+		size_t offset{ sizeof(Header) };
+		int width{ static_cast<int>(header.width) };
+		int height{ static_cast<int>(header.height) };
+		for (uint32_t level{ 0 }; level < header.mipCount; ++level)
+		{
+			const size_t mipBytes{ static_cast<size_t>(width) * height * sizeof(uint32_t) };
+			if (offset + mipBytes > fileSize)
+			{
+				texture.m_Mips.clear();
+				texture.m_File.Close();
+				return false;
+			}
+
+			texture.m_Mips.emplace_back(CookedTexture::MipLevel{ width, height, reinterpret_cast<const uint32_t*>(pData + offset) });
+
+			offset += mipBytes;
+			width = std::max(width / 2, 1);
+			height = std::max(height / 2, 1);
+		}
+
+		return true;
+	}
+
+	bool TextureCache::Cook(std::span<const uint8_t> source, std::vector<uint32_t>& texels, std::vector<Int2>& mipSizes)
+	{
+		SDL_RWops* pStream{ SDL_RWFromConstMem(source.data(), static_cast<int>(source.size())) };
+		SDL_Surface* pLoadedSurface{ IMG_Load_RW(pStream, 1) };
+		if (!pLoadedSurface)
+			return false;
+
+		// ABGR8888 is stored as R, G, B, A in memory, which matches DXGI_FORMAT_R8G8B8A8_UNORM
+		SDL_Surface* pSurface{ SDL_ConvertSurfaceFormat(pLoadedSurface, SDL_PIXELFORMAT_ABGR8888, 0) };
+		SDL_FreeSurface(pLoadedSurface);
+		if (!pSurface)
+			return false;
+
+		// Compute the size of every mip level down to 1x1
+		Int2 size{ pSurface->w, pSurface->h };
+		size_t texelCount{ 0 };
+		while (true)
+		{
+			mipSizes.emplace_back(size);
+			texelCount += static_cast<size_t>(size.x) * size.y;
+
+			if (size.x == 1 && size.y == 1)
+				break;
+
+			size = { std::max(size.x / 2, 1), std::max(size.y / 2, 1) };
+		}
+
+		texels.resize(texelCount);
+
+		// Copy the top level, the surface pitch can be larger than the row size
+		SDL_LockSurface(pSurface);
+		for (int y{ 0 }; y < pSurface->h; ++y)
+		{
+			const uint8_t* pRow{ static_cast<const uint8_t*>(pSurface->pixels) + static_cast<size_t>(y) * pSurface->pitch };
+			std::memcpy(texels.data() + static_cast<size_t>(y) * pSurface->w, pRow, pSurface->w * sizeof(uint32_t));
+		}
+		SDL_UnlockSurface(pSurface);
+		SDL_FreeSurface(pSurface);
+
+		// Every following level is a box filtered version of the previous one
+		size_t offset{ 0 };
+		for (size_t level{ 1 }; level < mipSizes.size(); ++level)
+		{
+			const size_t previousOffset{ offset };
+			offset += static_cast<size_t>(mipSizes[level - 1].x) * mipSizes[level - 1].y;
+
+			Downsample(texels.data() + previousOffset, mipSizes[level - 1], texels.data() + offset, mipSizes[level]);
+		}
+
+		return true;
+	}
+
+	void TextureCache::Downsample(const uint32_t* pSource, const Int2& sourceSize, uint32_t* pDestination, const Int2& destinationSize)
+	{
+		for (int y{ 0 }; y < destinationSize.y; ++y)
+		{
+			// Clamp for odd or 1 texel wide levels
+			const int y0{ std::min(y * 2, sourceSize.y - 1) };
+			const int y1{ std::min(y * 2 + 1, sourceSize.y - 1) };
+
+			for (int x{ 0 }; x < destinationSize.x; ++x)
+			{
+				const int x0{ std::min(x * 2, sourceSize.x - 1) };
+				const int x1{ std::min(x * 2 + 1, sourceSize.x - 1) };
+
+				const uint32_t texels[4]
+				{
+					pSource[y0 * sourceSize.x + x0],
+					pSource[y0 * sourceSize.x + x1],
+					pSource[y1 * sourceSize.x + x0],
+					pSource[y1 * sourceSize.x + x1]
+				};
+
+				// Average every channel separately, rounding to nearest
+				uint32_t result{ 0 };
+				for (int shift{ 0 }; shift < 32; shift += 8)
+				{
+					uint32_t sum{ 2 };
+					for (const uint32_t texel : texels)
+					{
+						sum += (texel >> shift) & 0xFF;
+					}
+					result |= (sum >> 2) << shift;
+				}
+
+				pDestination[y * destinationSize.x + x] = result;
+			}
+		}
+	}
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <span>
+
+#include "MappedFile.h"
+
+namespace dae
+{
+	// Texture with its complete mip chain stored as tightly packed R8G8B8A8 texels
+	class CookedTexture final
+	{
+	public:
+		struct MipLevel
+		{
+			int width{};
+			int height{};
+			const uint32_t* pTexels{ nullptr };
+		};
+
+		CookedTexture() = default;
+		~CookedTexture() = default;
+
+		CookedTexture(const CookedTexture&) = delete;
+		CookedTexture(CookedTexture&&) noexcept = delete;
+		CookedTexture& operator=(const CookedTexture&) = delete;
+		CookedTexture& operator=(CookedTexture&&) noexcept = delete;
+
+		// Getters
+		int GetWidth() const { return m_Mips.front().width; }
+		int GetHeight() const { return m_Mips.front().height; }
+		int GetMipCount() const { return static_cast<int>(m_Mips.size()); }
+		const MipLevel& GetMip(int level) const { return m_Mips[level]; }
+
+	private:
+		friend class TextureCache;
+
+		// The texels either live in the mapped cache file, or in memory when the cache could not be written
+		MappedFile m_File{};
+		std::vector<uint32_t> m_Texels{};
+
+		std::vector<MipLevel> m_Mips{};
+	};
+
+	// Converts source images (PNG, ...) into cooked textures once, keyed by the hash of the source bytes.
+	// Later loads memory map the cooked file and skip decoding and mip generation entirely.
+	class TextureCache final
+	{
+	public:
+		static std::unique_ptr<CookedTexture> Load(const std::string& path);
+		// Same as above for images that are already in memory, such as the ones embedded in a glb
+		static std::unique_ptr<CookedTexture> Load(std::span<const uint8_t> source);
+
+	private:
+		// Cooked file layout: [Header][mip 0 texels][mip 1 texels]...[mip N-1 texels]
+		struct Header
+		{
+			uint32_t magic{};
+			uint32_t version{};
+			uint64_t sourceHash{};
+			uint32_t width{};
+			uint32_t height{};
+			uint32_t mipCount{};
+			uint32_t reserved{};
+		};
+
+		static constexpr uint32_t m_Magic{ 0x58455444 }; // "DTEX"
+		static constexpr uint32_t m_Version{ 1 };
+		static constexpr const char* m_CacheDirectory{ "Resources/Cache/" };
+
+		static uint64_t HashBytes(std::span<const uint8_t> bytes);
+		static std::string GetCachePath(uint64_t hash);
+
+		static bool MapCookedFile(const std::string& cachePath, uint64_t hash, CookedTexture& texture);
+		static bool Cook(std::span<const uint8_t> source, std::vector<uint32_t>& texels, std::vector<Int2>& mipSizes);
+		static void Downsample(const uint32_t* pSource, const Int2& sourceSize, uint32_t* pDestination, const Int2& destinationSize);
+	};
+}
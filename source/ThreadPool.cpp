@@ -0,0 +1,49 @@
+#include "pch.h"
+#include "ThreadPool.h"
+
+namespace dae
+{
+	ThreadPool::ThreadPool(uint32_t nrThreads)
+	{
+		m_Threads.reserve(nrThreads);
+		for (uint32_t i{ 0 }; i < nrThreads; ++i)
+		{
+			m_Threads.emplace_back(&ThreadPool::WorkerLoop, this);
+		}
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard lock{ m_Mutex };
+			m_IsStopping = true;
+		}
+		m_Condition.notify_all();
+
+		// Workers drain the queue before they exit, so every future handed out gets a value
+		for (std::thread& thread : m_Threads)
+		{
+			thread.join();
+		}
+	}
+
+	void ThreadPool::WorkerLoop()
+	{
+		while (true)
+		{
+			std::function<void()> task{};
+			{
+				std::unique_lock lock{ m_Mutex };
+				m_Condition.wait(lock, [this] { return m_IsStopping || !m_Tasks.empty(); });
+
+				if (m_Tasks.empty())
+					return;
+
+				task = std::move(m_Tasks.front());
+				m_Tasks.pop();
+			}
+
+			task();
+		}
+	}
+}
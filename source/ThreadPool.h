@@ -0,0 +1,53 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+namespace dae
+{
+	// Fixed set of worker threads consuming a shared task queue
+	class ThreadPool final
+	{
+	public:
+		explicit ThreadPool(uint32_t nrThreads);
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool(ThreadPool&&) noexcept = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+		ThreadPool& operator=(ThreadPool&&) noexcept = delete;
+
+		template <typename Func>
+		std::future<std::invoke_result_t<Func>> Enqueue(Func&& func)
+		{
+			using ReturnType = std::invoke_result_t<Func>;
+
+			// packaged_task is move only, std::function needs something copyable
+			auto pTask{ std::make_shared<std::packaged_task<ReturnType()>>(std::forward<Func>(func)) };
+			std::future<ReturnType> future{ pTask->get_future() };
+			{
+				std::lock_guard lock{ m_Mutex };
+				m_Tasks.emplace([pTask] { (*pTask)(); });
+			}
+			m_Condition.notify_one();
+
+			return future;
+		}
+
+		// Getters
+		uint32_t GetNrThreads() const { return static_cast<uint32_t>(m_Threads.size()); }
+
+	private:
+		std::vector<std::thread> m_Threads{};
+		std::queue<std::function<void()>> m_Tasks{};
+
+		std::mutex m_Mutex{};
+		std::condition_variable m_Condition{};
+		bool m_IsStopping{ false };
+
+		void WorkerLoop();
+	};
+}
@@ -0,0 +1,170 @@
+#include "pch.h"
+#include "TriangleSetup.h"
+
+#include <immintrin.h>
+
+namespace dae
+{
+	void TriangleSetup::Setup(const std::vector<Vertex_Out>& verticesOut, const std::vector<uint32_t>& triangles, float width, float height, bool isAntiAliased, std::vector<TriangleSetup>& setups)
+	{
+		const size_t nrTriangles{ triangles.size() / 3 };
+		setups.resize(nrTriangles);
+
+		size_t nrSetups{ 0 };
+		for (size_t first{ 0 }; first < nrTriangles; first += m_BatchSize)
+		{
+			nrSetups += SetupBatch(verticesOut, triangles.data() + first * 3, std::min(m_BatchSize, nrTriangles - first), width, height, isAntiAliased, setups.data() + nrSetups);
+		}
+		setups.resize(nrSetups);
+	}
+
+	size_t TriangleSetup::SetupBatch(const std::vector<Vertex_Out>& verticesOut, const uint32_t* pTriangles, size_t count, float width, float height, bool isAntiAliased, TriangleSetup* pSetups)
+	{
+		// Gather the vertices into SoA form, a partial batch repeats its last triangle in the unused lanes
+		alignas(32) float x[3][m_BatchSize];
+		alignas(32) float y[3][m_BatchSize];
+		alignas(32) float z[3][m_BatchSize];
+		alignas(32) float w[3][m_BatchSize];
+		alignas(32) float u[3][m_BatchSize];
+		alignas(32) float v[3][m_BatchSize];
+		for (size_t lane{ 0 }; lane < m_BatchSize; ++lane)
+		{
+			const uint32_t* pIndices{ pTriangles + std::min(lane, count - 1) * 3 };
+			for (int vertex{ 0 }; vertex < 3; ++vertex)
+			{
+				const Vertex_Out& vertexOut{ verticesOut[pIndices[vertex]] };
+				x[vertex][lane] = vertexOut.pos.x;
+				y[vertex][lane] = vertexOut.pos.y;
+				z[vertex][lane] = vertexOut.pos.z;
+				w[vertex][lane] = vertexOut.pos.w;
+				u[vertex][lane] = vertexOut.uv.x;
+				v[vertex][lane] = vertexOut.uv.y;
+			}
+		}
+
+		const __m256 one{ _mm256_set1_ps(1.f) };
+		const __m256 half{ _mm256_set1_ps(.5f) };
+		const __m256 absMask{ _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF)) };
+
+		const __m256 x0{ _mm256_load_ps(x[0]) };
+		const __m256 x1{ _mm256_load_ps(x[1]) };
+		const __m256 x2{ _mm256_load_ps(x[2]) };
+		const __m256 y0{ _mm256_load_ps(y[0]) };
+		const __m256 y1{ _mm256_load_ps(y[1]) };
+		const __m256 y2{ _mm256_load_ps(y[2]) };
+
+		// Bounding box clamped to the screen, then tightened to the first and last pixel centers inside the extent of the triangle
+		const __m256 extentMinX{ _mm256_min_ps(x0, _mm256_min_ps(x1, x2)) };
+		const __m256 extentMinY{ _mm256_min_ps(y0, _mm256_min_ps(y1, y2)) };
+		const __m256 extentMaxX{ _mm256_max_ps(x0, _mm256_max_ps(x1, x2)) };
+		const __m256 extentMaxY{ _mm256_max_ps(y0, _mm256_max_ps(y1, y2)) };
+
+		__m256 minX{ _mm256_floor_ps(_mm256_max_ps(_mm256_setzero_ps(), extentMinX)) };
+		__m256 minY{ _mm256_floor_ps(_mm256_max_ps(_mm256_setzero_ps(), extentMinY)) };
+		__m256 maxX{ _mm256_ceil_ps(_mm256_min_ps(_mm256_set1_ps(width - 1.f), extentMaxX)) };
+		__m256 maxY{ _mm256_ceil_ps(_mm256_min_ps(_mm256_set1_ps(height - 1.f), extentMaxY)) };
+		if (!isAntiAliased)
+		{
+			minX = _mm256_max_ps(minX, _mm256_ceil_ps(_mm256_sub_ps(extentMinX, half)));
+			minY = _mm256_max_ps(minY, _mm256_ceil_ps(_mm256_sub_ps(extentMinY, half)));
+			maxX = _mm256_min_ps(maxX, _mm256_add_ps(_mm256_floor_ps(_mm256_sub_ps(extentMaxX, half)), one));
+			maxY = _mm256_min_ps(maxY, _mm256_add_ps(_mm256_floor_ps(_mm256_sub_ps(extentMaxY, half)), one));
+		}
+
+		// The planes are evaluated relative to the center of the first pixel, which keeps them precise far from the origin
+		const __m256 originX{ _mm256_add_ps(minX, half) };
+		const __m256 originY{ _mm256_add_ps(minY, half) };
+
+		// Culling already rejected the triangles without area
+		const __m256 area{ _mm256_fmsub_ps(_mm256_sub_ps(x1, x0), _mm256_sub_ps(y2, y0), _mm256_mul_ps(_mm256_sub_ps(y1, y0), _mm256_sub_ps(x2, x0))) };
+		const __m256 invArea{ _mm256_div_ps(one, area) };
+
+		// Edge function of the edge from p to q, scaled by the inverse area, gives the weight of the vertex opposite the edge
+		const auto createWeight{ [&](__m256 px, __m256 py, __m256 qx, __m256 qy, __m256& a, __m256& b, __m256& c)
+			{
+				a = _mm256_mul_ps(_mm256_sub_ps(py, qy), invArea);
+				b = _mm256_mul_ps(_mm256_sub_ps(qx, px), invArea);
+				c = _mm256_fmadd_ps(a, _mm256_sub_ps(originX, px), _mm256_mul_ps(b, _mm256_sub_ps(originY, py)));
+			} };
+
+		__m256 weight0A, weight0B, weight0C;
+		__m256 weight1A, weight1B, weight1C;
+		createWeight(x1, y1, x2, y2, weight0A, weight0B, weight0C);
+		createWeight(x2, y2, x0, y0, weight1A, weight1B, weight1C);
+
+		// Plane through the values q0, q1 and q2 at the vertices
+		const auto createPlane{ [&](__m256 q0, __m256 q1, __m256 q2, float* pA, float* pB, float* pC)
+			{
+				const __m256 delta0{ _mm256_sub_ps(q0, q2) };
+				const __m256 delta1{ _mm256_sub_ps(q1, q2) };
+				_mm256_store_ps(pA, _mm256_fmadd_ps(delta0, weight0A, _mm256_mul_ps(delta1, weight1A)));
+				_mm256_store_ps(pB, _mm256_fmadd_ps(delta0, weight0B, _mm256_mul_ps(delta1, weight1B)));
+				_mm256_store_ps(pC, _mm256_fmadd_ps(delta0, weight0C, _mm256_fmadd_ps(delta1, weight1C, q2)));
+			} };
+
+		alignas(32) float depthA[m_BatchSize], depthB[m_BatchSize], depthC[m_BatchSize];
+		createPlane(
+			_mm256_div_ps(one, _mm256_load_ps(z[0])),
+			_mm256_div_ps(one, _mm256_load_ps(z[1])),
+			_mm256_div_ps(one, _mm256_load_ps(z[2])),
+			depthA, depthB, depthC);
+
+		alignas(32) float inverseWA[m_BatchSize], inverseWB[m_BatchSize], inverseWC[m_BatchSize];
+		createPlane(
+			_mm256_div_ps(one, _mm256_load_ps(w[0])),
+			_mm256_div_ps(one, _mm256_load_ps(w[1])),
+			_mm256_div_ps(one, _mm256_load_ps(w[2])),
+			inverseWA, inverseWB, inverseWC);
+
+		// Ratio of the uv area to the screen area, the log is taken per triangle below
+		const __m256 u0{ _mm256_load_ps(u[0]) };
+		const __m256 v0{ _mm256_load_ps(v[0]) };
+		const __m256 uvCross{ _mm256_fmsub_ps(
+			_mm256_sub_ps(_mm256_load_ps(u[1]), u0), _mm256_sub_ps(_mm256_load_ps(v[2]), v0),
+			_mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(v[1]), v0), _mm256_sub_ps(_mm256_load_ps(u[2]), u0))) };
+		const __m256 uvArea{ _mm256_max_ps(_mm256_and_ps(uvCross, absMask), _mm256_set1_ps(FLT_MIN)) };
+
+		alignas(32) float uvRatio[m_BatchSize];
+		_mm256_store_ps(uvRatio, _mm256_div_ps(uvArea, _mm256_and_ps(area, absMask)));
+
+		alignas(32) float weights[6][m_BatchSize];
+		_mm256_store_ps(weights[0], weight0A);
+		_mm256_store_ps(weights[1], weight0B);
+		_mm256_store_ps(weights[2], weight0C);
+		_mm256_store_ps(weights[3], weight1A);
+		_mm256_store_ps(weights[4], weight1B);
+		_mm256_store_ps(weights[5], weight1C);
+
+		alignas(32) int bounds[4][m_BatchSize];
+		_mm256_store_si256(reinterpret_cast<__m256i*>(bounds[0]), _mm256_cvttps_epi32(minX));
+		_mm256_store_si256(reinterpret_cast<__m256i*>(bounds[1]), _mm256_cvttps_epi32(minY));
+		_mm256_store_si256(reinterpret_cast<__m256i*>(bounds[2]), _mm256_cvttps_epi32(maxX));
+		_mm256_store_si256(reinterpret_cast<__m256i*>(bounds[3]), _mm256_cvttps_epi32(maxY));
+
+		// Write the SoA results out as one record per triangle, skipping the ones without a pixel center
+		size_t nrSetups{ 0 };
+		for (size_t lane{ 0 }; lane < count; ++lane)
+		{
+			const int nrColumns{ bounds[2][lane] - bounds[0][lane] };
+			const int nrRows{ bounds[3][lane] - bounds[1][lane] };
+			if (nrColumns <= 0 || nrRows <= 0) continue;
+
+			TriangleSetup& setup{ pSetups[nrSetups++] };
+			setup.weight0 = { weights[0][lane], weights[1][lane], weights[2][lane] };
+			setup.weight1 = { weights[3][lane], weights[4][lane], weights[5][lane] };
+			setup.inverseDepth = { depthA[lane], depthB[lane], depthC[lane] };
+			setup.inverseW = { inverseWA[lane], inverseWB[lane], inverseWC[lane] };
+			setup.min = { bounds[0][lane], bounds[1][lane] };
+			setup.max = { bounds[2][lane], bounds[3][lane] };
+			const int nrPixels{ nrColumns * nrRows };
+			if (isAntiAliased)
+				setup.path = RasterPath::BoundingBox;
+			else
+				setup.path = nrPixels <= m_MaxMicroPixels ? RasterPath::Micro : nrPixels >= m_MinSpanPixels ? RasterPath::Span : RasterPath::BoundingBox;
+			setup.uvLod = .5f * std::log2(uvRatio[lane]);
+			std::copy_n(pTriangles + lane * 3, 3, setup.indices);
+		}
+
+		return nrSetups;
+	}
+}
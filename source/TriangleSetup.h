@@ -0,0 +1,77 @@
+#pragma once
+#include "DataTypes.h"
+
+namespace dae
+{
+	// Screen space plane a * x + b * y + c, x and y are pixels relative to the first pixel of the bounding box of a triangle
+	struct ScreenPlane
+	{
+		float a{};
+		float b{};
+		float c{};
+
+		float Evaluate(float x, float y) const { return a * x + b * y + c; }
+	};
+
+	// How the pixels of a triangle are visited, picked from the size of its bounding box
+	enum class RasterPath : uint8_t
+	{
+		// At most TriangleSetup::m_MaxMicroPixels pixel centers, tested all at once
+		Micro,
+		// Every pixel of the bounding box is tested
+		BoundingBox,
+		// Large triangles walk their edges and only visit the pixels between them on each row
+		Span
+	};
+
+	// Everything the rasterizer needs to walk the pixels of a triangle.
+	// Setup runs on batches of eight triangles in SoA form, so it costs about the same for a one pixel triangle as for a large one.
+	struct TriangleSetup
+	{
+		// Barycentric weights of the first two vertices, the weight of the third is one minus both
+		ScreenPlane weight0{};
+		ScreenPlane weight1{};
+
+		// Inverse depth and inverse w interpolate linearly in screen space
+		ScreenPlane inverseDepth{};
+		ScreenPlane inverseW{};
+
+		// Pixels min up to, but not including, max, tightened to the pixel centers the triangle can cover.
+		// Anti-aliased triangles keep the whole box, their samples and edge coverage reach past the pixel centers.
+		Int2 min{};
+		Int2 max{};
+
+		RasterPath path{ RasterPath::BoundingBox };
+
+		// Mip level from the uv area of the triangle compared to its area on screen
+		float uvLod{};
+
+		uint32_t indices[3]{};
+
+		// Plane through the values q0, q1 and q2 at the vertices, a value divided by w interpolates with it in perspective
+		ScreenPlane CreatePlane(float q0, float q1, float q2) const
+		{
+			const float delta0{ q0 - q2 };
+			const float delta1{ q1 - q2 };
+			return
+			{
+				delta0 * weight0.a + delta1 * weight1.a,
+				delta0 * weight0.b + delta1 * weight1.b,
+				delta0 * weight0.c + delta1 * weight1.c + q2
+			};
+		}
+
+		static constexpr int m_MaxMicroPixels{ 4 };
+		static constexpr int m_MinSpanPixels{ 256 };
+
+		// One record per triangle that covers a pixel center, the triangles are three indices each into the transformed vertices.
+		// Anti-aliased triangles all take the bounding box path, which also handles partially covered pixels.
+		static void Setup(const std::vector<Vertex_Out>& verticesOut, const std::vector<uint32_t>& triangles, float width, float height, bool isAntiAliased, std::vector<TriangleSetup>& setups);
+
+	private:
+		static constexpr size_t m_BatchSize{ 8 };
+
+		// Returns the number of records written, triangles that miss every pixel center get none
+		static size_t SetupBatch(const std::vector<Vertex_Out>& verticesOut, const uint32_t* pTriangles, size_t count, float width, float height, bool isAntiAliased, TriangleSetup* pSetups);
+	};
+}
@@ -4,9 +4,44 @@
 
 namespace dae::Utils
 {
-	//Just parses vertices and indices
 #pragma warning(push)
 #pragma warning(disable : 4505) //Warning unreferenced local function
+	static void CalculateTangents(std::vector<Vertex_In>& vertices, const std::vector<uint32_t>& indices)
+	{
+		//Cheap Tangent Calculations
+		for (uint32_t i = 0; i < indices.size(); i += 3)
+		{
+			uint32_t index0 = indices[i];
+			uint32_t index1 = indices[size_t(i) + 1];
+			uint32_t index2 = indices[size_t(i) + 2];
+
+			const Vector3& p0 = vertices[index0].pos;
+			const Vector3& p1 = vertices[index1].pos;
+			const Vector3& p2 = vertices[index2].pos;
+			const Vector2& uv0 = vertices[index0].uv;
+			const Vector2& uv1 = vertices[index1].uv;
+			const Vector2& uv2 = vertices[index2].uv;
+
+			const Vector3 edge0 = p1 - p0;
+			const Vector3 edge1 = p2 - p0;
+			const Vector2 diffX = Vector2(uv1.x - uv0.x, uv2.x - uv0.x);
+			const Vector2 diffY = Vector2(uv1.y - uv0.y, uv2.y - uv0.y);
+			float r = 1.f / Vector2::Cross(diffX, diffY);
+
+			Vector3 tangent = (edge0 * diffY.y - edge1 * diffY.x) * r;
+			vertices[index0].tan += tangent;
+			vertices[index1].tan += tangent;
+			vertices[index2].tan += tangent;
+		}
+
+		//Create the Tangents (reject)
+		for (auto& v : vertices)
+		{
+			v.tan = Vector3::Reject(v.tan, v.norm).Normalized();
+		}
+	}
+
+	//Just parses vertices and indices
 	static bool ParseOBJ(const std::string& filename, std::vector<Vertex_In>& vertices, std::vector<uint32_t>& indices, bool flipAxisAndWinding = true)
 	{
 		std::ifstream file(filename);
@@ -113,37 +148,10 @@ namespace dae::Utils
 			file.ignore(1000, '\n');
 		}
 
-		//Cheap Tangent Calculations
-		for (uint32_t i = 0; i < indices.size(); i += 3)
-		{
-			uint32_t index0 = indices[i];
-			uint32_t index1 = indices[size_t(i) + 1];
-			uint32_t index2 = indices[size_t(i) + 2];
-
-			const Vector3& p0 = vertices[index0].pos;
-			const Vector3& p1 = vertices[index1].pos;
-			const Vector3& p2 = vertices[index2].pos;
-			const Vector2& uv0 = vertices[index0].uv;
-			const Vector2& uv1 = vertices[index1].uv;
-			const Vector2& uv2 = vertices[index2].uv;
-
-			const Vector3 edge0 = p1 - p0;
-			const Vector3 edge1 = p2 - p0;
-			const Vector2 diffX = Vector2(uv1.x - uv0.x, uv2.x - uv0.x);
-			const Vector2 diffY = Vector2(uv1.y - uv0.y, uv2.y - uv0.y);
-			float r = 1.f / Vector2::Cross(diffX, diffY);
-
-			Vector3 tangent = (edge0 * diffY.y - edge1 * diffY.x) * r;
-			vertices[index0].tan += tangent;
-			vertices[index1].tan += tangent;
-			vertices[index2].tan += tangent;
-		}
+		CalculateTangents(vertices, indices);
 
-		//Create the Tangents (reject)
 		for (auto& v : vertices)
 		{
-			v.tan = Vector3::Reject(v.tan, v.norm).Normalized();
-
 			if (flipAxisAndWinding)
 			{
 				v.pos.z *= -1.f;
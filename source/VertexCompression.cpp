@@ -0,0 +1,154 @@
+#include "pch.h"
+#include "VertexCompression.h"
+
+namespace dae
+{
+	namespace VertexCompression
+	{
+		CompactVertices Compress(const std::vector<Vertex_In>& vertices, const std::vector<uint32_t>& indices)
+		{
+			CompactVertices result{};
+			if (vertices.empty()) return result;
+
+			// Bounds of the mesh, every position is stored as a 16 bit fraction of them
+			Vector3 boundsMin{ vertices.front().pos };
+			Vector3 boundsMax{ vertices.front().pos };
+			for (const Vertex_In& vertex : vertices)
+			{
+				for (int axis{ 0 }; axis < 3; ++axis)
+				{
+					boundsMin[axis] = std::min(boundsMin[axis], vertex.pos[axis]);
+					boundsMax[axis] = std::max(boundsMax[axis], vertex.pos[axis]);
+				}
+			}
+
+			constexpr float maxQuantized{ 65535.f };
+
+			Vector3 step{};
+			Vector3 invStep{};
+			for (int axis{ 0 }; axis < 3; ++axis)
+			{
+				// Flat meshes still need a non zero step
+				step[axis] = std::max(boundsMax[axis] - boundsMin[axis], FLT_EPSILON) / maxQuantized;
+				invStep[axis] = 1.f / step[axis];
+			}
+
+			result.decodeMatrix = Matrix::CreateScale(step) * Matrix::CreateTranslation(boundsMin);
+
+			result.vertices.reserve(vertices.size());
+			for (const Vertex_In& vertex : vertices)
+			{
+				Vertex_Compact compact{};
+
+				for (int axis{ 0 }; axis < 3; ++axis)
+				{
+					const float quantized{ (vertex.pos[axis] - boundsMin[axis]) * invStep[axis] };
+					compact.pos[axis] = static_cast<uint16_t>(Clamp(quantized, 0.f, maxQuantized) + .5f);
+				}
+
+				compact.norm = EncodeOctahedral(vertex.norm);
+				compact.tan = EncodeOctahedral(vertex.tan);
+
+				compact.uv[0] = FloatToHalf(vertex.uv.x);
+				compact.uv[1] = FloatToHalf(vertex.uv.y);
+
+				compact.col[0] = static_cast<uint8_t>(Clamp(vertex.col.r, 0.f, 1.f) * 255.f + .5f);
+				compact.col[1] = static_cast<uint8_t>(Clamp(vertex.col.g, 0.f, 1.f) * 255.f + .5f);
+				compact.col[2] = static_cast<uint8_t>(Clamp(vertex.col.b, 0.f, 1.f) * 255.f + .5f);
+				compact.col[3] = 255;
+
+				result.vertices.emplace_back(compact);
+			}
+
+			if (vertices.size() <= std::numeric_limits<uint16_t>::max() + size_t{ 1 })
+			{
+				result.indices16.reserve(indices.size());
+				for (const uint32_t index : indices)
+				{
+					result.indices16.emplace_back(static_cast<uint16_t>(index));
+				}
+			}
+			else
+			{
+				result.indices32 = indices;
+			}
+
+			return result;
+		}
+
+		uint16_t EncodeOctahedral(const Vector3& direction)
+		{
+			const float length{ std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z) };
+			if (length <= FLT_EPSILON) return 0;
+
+			// Project onto the octahedron, then unfold the lower hemisphere onto the outer triangles of the square
+			float x{ direction.x / length };
+			float y{ direction.y / length };
+			if (direction.z < 0.f)
+			{
+				const float foldedX{ (1.f - std::abs(y)) * (x >= 0.f ? 1.f : -1.f) };
+				const float foldedY{ (1.f - std::abs(x)) * (y >= 0.f ? 1.f : -1.f) };
+				x = foldedX;
+				y = foldedY;
+			}
+
+			const float scaledX{ Clamp(x, -1.f, 1.f) * 127.f };
+			const float scaledY{ Clamp(y, -1.f, 1.f) * 127.f };
+			const Vector3 normalized{ direction.Normalized() };
+
+			// The nearest point on the square is not always the one nearest on the sphere, so every corner of the cell is tried
+			uint16_t encoded{};
+			float bestDot{ -FLT_MAX };
+			for (const float quantizedX : { std::floor(scaledX), std::ceil(scaledX) })
+			{
+				for (const float quantizedY : { std::floor(scaledY), std::ceil(scaledY) })
+				{
+					const uint16_t candidate{ static_cast<uint16_t>(static_cast<uint8_t>(static_cast<int8_t>(quantizedX))
+						| (static_cast<uint8_t>(static_cast<int8_t>(quantizedY)) << 8)) };
+
+					const float dot{ Vector3::Dot(DecodeOctahedral(candidate), normalized) };
+					if (dot > bestDot)
+					{
+						bestDot = dot;
+						encoded = candidate;
+					}
+				}
+			}
+
+			return encoded;
+		}
+
+		uint16_t FloatToHalf(float value)
+		{
+			uint32_t bits{};
+			std::memcpy(&bits, &value, sizeof(float));
+
+			const auto sign{ static_cast<uint16_t>((bits >> 16) & 0x8000) };
+			bits &= 0x7FFFFFFF;
+
+			// Too large for a half, or infinity and NaN
+			if (bits >= 0x47800000)
+				return sign | (bits > 0x7F800000 ? 0x7E00 : 0x7C00);
+
+			// Too small even for a subnormal half
+			if (bits < 0x33000000)
+				return sign;
+
+			// Subnormal half, shift the mantissa including its implicit bit and round to nearest
+			if (bits < 0x38800000)
+			{
+				const uint32_t exponent{ bits >> 23 };
+				const uint32_t mantissa{ (bits & 0x7FFFFF) | 0x800000 };
+				const uint32_t shift{ 126 - exponent };
+
+				return sign | static_cast<uint16_t>((mantissa + (1u << (shift - 1))) >> shift);
+			}
+
+			// Normal half, rebias the exponent and round to nearest even
+			bits -= 0x38000000;
+			bits += 0xFFF + ((bits >> 13) & 1);
+
+			return sign | static_cast<uint16_t>(bits >> 13);
+		}
+	}
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include "DataTypes.h"
+
+namespace dae
+{
+	// 18 byte vertex, compared to the 56 bytes of Vertex_In.
+	// Positions are quantized to the bounds of the mesh, normals and tangents are octahedral encoded in 2 x 8 bits,
+	// UVs are half floats and the color is RGBA8.
+	struct Vertex_Compact
+	{
+		uint16_t pos[3]{};
+		uint16_t norm{};
+		uint16_t tan{};
+		uint16_t uv[2]{};
+		uint8_t col[4]{};
+	};
+
+	struct CompactVertices
+	{
+		std::vector<Vertex_Compact> vertices{};
+
+		// Only one of the index buffers is filled, 16 bit indices are used whenever the vertex count allows it
+		std::vector<uint16_t> indices16{};
+		std::vector<uint32_t> indices32{};
+
+		// Maps the quantized positions back to object space, folded into the world matrix by the vertex stage
+		Matrix decodeMatrix{};
+	};
+
+	namespace VertexCompression
+	{
+		CompactVertices Compress(const std::vector<Vertex_In>& vertices, const std::vector<uint32_t>& indices);
+
+		// Picks the rounding of both axes that decodes closest to the direction, which keeps the largest error near 0.6 degrees instead of 1
+		uint16_t EncodeOctahedral(const Vector3& direction);
+		uint16_t FloatToHalf(float value);
+
+		inline Vector3 DecodeOctahedral(uint16_t encoded)
+		{
+			const float x{ static_cast<int8_t>(encoded & 0xFF) / 127.f };
+			const float y{ static_cast<int8_t>(encoded >> 8) / 127.f };
+
+			// Fold the lower hemisphere back over the diagonals of the octahedron
+			Vector3 direction{ x, y, 1.f - std::abs(x) - std::abs(y) };
+			const float t{ std::max(-direction.z, 0.f) };
+			direction.x += direction.x >= 0.f ? -t : t;
+			direction.y += direction.y >= 0.f ? -t : t;
+
+			return direction.Normalized();
+		}
+
+		inline float HalfToFloat(uint16_t half)
+		{
+			const uint32_t sign{ static_cast<uint32_t>(half & 0x8000) << 16 };
+			const uint32_t exponent{ (half >> 10) & 0x1Fu };
+			const uint32_t mantissa{ half & 0x3FFu };
+
+			uint32_t bits{};
+			if (exponent == 0)
+			{
+				// Zero or subnormal
+				const float value{ static_cast<float>(mantissa) * (1.f / 16777216.f) };
+				std::memcpy(&bits, &value, sizeof(float));
+				bits |= sign;
+			}
+			else if (exponent == 0x1F)
+			{
+				// Infinity or NaN
+				bits = sign | 0x7F800000u | (mantissa << 13);
+			}
+			else
+			{
+				bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+			}
+
+			float result{};
+			std::memcpy(&result, &bits, sizeof(float));
+			return result;
+		}
+
+		inline ColorRGB DecodeColor(const uint8_t color[4])
+		{
+			constexpr float scale{ 1.f / 255.f };
+			return { color[0] * scale, color[1] * scale, color[2] * scale };
+		}
+	}
+}
@@ -17,10 +17,6 @@ void ShutDown(SDL_Window* pWindow)
 
 int main(int argc, char* args[])
 {
-	//Unreferenced parameters
-	(void)argc;
-	(void)args;
-
 	//Create window + surfaces
 	SDL_Init(SDL_INIT_VIDEO);
 
@@ -38,7 +34,20 @@ int main(int argc, char* args[])
 
 	//Initialize "framework"
 	const auto pTimer{ new Timer() };
-	const auto pRenderer{ new Renderer(pWindow) };
+	//Optional scene or model: DualRasterizer.exe <scene.json>, DualRasterizer.exe <model.glb> or DualRasterizer.exe <mesh.obj> [memory budget in MB]
+	const std::string path{ argc > 1 ? args[1] : "" };
+	const auto pRenderer{ path.ends_with(".json") ? new Renderer(pWindow, path) : new Renderer(pWindow) };
+
+	if (path.ends_with(".glb"))
+	{
+		pRenderer->AddModel(path, { .0f, .0f, 50.f });
+	}
+	else if (!path.empty() && !path.ends_with(".json"))
+	{
+		// OBJ files are streamed from disk, within the memory budget
+		const size_t budgetInMB{ argc > 2 ? std::strtoull(args[2], nullptr, 10) : 256 };
+		pRenderer->AddStreamingMesh(path, budgetInMB * 1024 * 1024, { .0f, .0f, 50.f });
+	}
 
 	//Start loop
 	pTimer->Start();
@@ -107,6 +116,58 @@ int main(int argc, char* args[])
 					std::cout << "**(SOFTWARE) BoundingBox Visualization "
 						<< (pRenderer->ToggleBoundingBox() ? "ON" : "OFF") << '\n';
 					break;
+				case SDLK_1:
+					if (pRenderer->IsHardwareMode()) break;
+					// Change console text color to purple
+					SetConsoleTextAttribute(GetStdHandle(STD_OUTPUT_HANDLE), 5);
+					std::cout << "**(SOFTWARE) Compact Vertices "
+						<< (pRenderer->ToggleCompactVertices() ? "ON" : "OFF") << '\n';
+					break;
+				case SDLK_2:
+					if (pRenderer->IsHardwareMode()) break;
+					// Change console text color to purple
+					SetConsoleTextAttribute(GetStdHandle(STD_OUTPUT_HANDLE), 5);
+					std::cout << "**(SOFTWARE) LOD Selection "
+						<< (pRenderer->ToggleLods() ? "ON" : "OFF") << '\n';
+					break;
+				case SDLK_3:
+				{
+					int mouseX{};
+					int mouseY{};
+					SDL_GetMouseState(&mouseX, &mouseY);
+					pRenderer->PickInstance(mouseX, mouseY);
+					break;
+				}
+				case SDLK_4:
+					if (pRenderer->IsHardwareMode()) break;
+					// Change console text color to purple
+					SetConsoleTextAttribute(GetStdHandle(STD_OUTPUT_HANDLE), 5);
+					std::cout << "**(SOFTWARE) Occlusion Culling "
+						<< (pRenderer->ToggleOcclusionCulling() ? "ON" : "OFF") << '\n';
+					break;
+				case SDLK_5:
+					pRenderer->CycleSampleCount();
+					break;
+				case SDLK_6:
+					if (pRenderer->IsHardwareMode()) break;
+					// Change console text color to purple
+					SetConsoleTextAttribute(GetStdHandle(STD_OUTPUT_HANDLE), 5);
+					std::cout << "**(SOFTWARE) Edge Anti-Aliasing "
+						<< (pRenderer->ToggleEdgeAntiAliasing() ? "ON" : "OFF") << '\n';
+					break;
+				case SDLK_7:
+					pRenderer->CycleDepthFormat();
+					break;
+				case SDLK_8:
+					if (pRenderer->IsHardwareMode()) break;
+					// Change console text color to purple
+					SetConsoleTextAttribute(GetStdHandle(STD_OUTPUT_HANDLE), 5);
+					std::cout << "**(SOFTWARE) Coverage Buffer "
+						<< (pRenderer->ToggleCoverageBuffer() ? "ON" : "OFF") << '\n';
+					break;
+				case SDLK_9:
+					pRenderer->CycleShadingRateMode();
+					break;
 				case SDLK_F9:
 					pRenderer->CycleCullMode();
 					break;